@@ -9,6 +9,7 @@
 #include <guestutil/mem.hh>
 #include <guestutil/event/Loop.hh>
 #include <guestutil/event/MemEventRegistry.hh>
+#include <guestutil/symbol/SymbolIndex.hh>
 #include <EventEmitter.hh>
 #include <signal.hh>
 
@@ -23,16 +24,18 @@ class MemEventCallback: public EventCallback<vmi_instance_t, vmi_event_t*> {
 private:
   event::Loop &loop;
   event::memory::MemEventRegistry &reg;
+  const symbol::SymbolIndex &symbols;
   int times;
   bool interrupted;
 public:
   MemEventCallback(
     event::Loop &_loop,
     event::memory::MemEventRegistry &_reg,
+    const symbol::SymbolIndex &_symbols,
     std::shared_ptr<event::memory::MemEvent> memEvent
   ):
     EventCallback<vmi_instance_t, vmi_event_t*>(false),
-    loop(_loop), reg(_reg), times(0), interrupted(false) {
+    loop(_loop), reg(_reg), symbols(_symbols), times(0), interrupted(false) {
     memEvent->once(event::memory::MemEventKey::UNREGISTERED, [this](vmi_instance_t, vmi_event_t*) {
       std::cout << "Memory event unregistered, pausing the event loop for stop" << std::endl;
       loop.schedulePause([this]() {
@@ -55,7 +58,11 @@ public:
     std::cout << F_D32(times) << '\t'
       << F_D32(event->vcpu_id) << '\t'
       << std::left << std::setfill(' ') << std::setw(3) << pp::MemoryAccess(vmiMemEvent.out_access) << ' '
-      << F_UH64(vmiMemEvent.gla) << std::endl;
+      << symbols.describe(vmiMemEvent.gla);
+    if (event->x86_regs) {
+      std::cout << " from " << symbols.describe(event->x86_regs->rip);
+    }
+    std::cout << std::endl;
     times++;
   }
 
@@ -92,8 +99,11 @@ int doTheJob() {
     reg.unregisterForGFN(gfn);
   };
 
+  // Built once here, so that the callback only does lookups
+  symbol::SymbolIndex &symbols = symbol::SymbolIndex::of(vmi);
+
   auto memEvent = reg.registerForGFN(gfn);
-  memEvent->on(event::memory::MemEventKey::BEFORE, std::make_shared<MemEventCallback>(loop, reg, memEvent));
+  memEvent->on(event::memory::MemEventKey::BEFORE, std::make_shared<MemEventCallback>(loop, reg, symbols, memEvent));
 
   vm.resume();
   try {
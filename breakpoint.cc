@@ -7,6 +7,7 @@
 #include <guestutil/ProcessList.hh>
 #include <guestutil/mem.hh>
 #include <guestutil/mem/TempMem.hh>
+#include <guestutil/symbol/SymbolIndex.hh>
 #include <guestutil/breakpoint/Breakpoint.hh>
 #include <guestutil/breakpoint/BreakpointRegistry.hh>
 #include <guestutil/event/Loop.hh>
@@ -60,6 +61,8 @@ int doTheJob() {
   reg.registerEvent();
   addr_t addrWrite = symbol::translateKernelSymbol(vmi, "__x64_sys_write");
   addr_t addrRead = symbol::translateKernelSymbol(vmi, "__x64_sys_read");
+  // Built once here, so that the callbacks only do lookups
+  symbol::SymbolIndex &symbols = symbol::SymbolIndex::of(vmi);
   int i = 0;
   int j = 0;
   std::cout << "Creating onPause" << std::endl;
@@ -74,15 +77,15 @@ int doTheJob() {
     loop.stop("onPause");
   };
   std::cout << "Setting breakpoint" << std::endl;
-  writeBp = reg.setBreakpoint(addrWrite, [&i, &loop, &disableWrite](vmi_event_t *event) {
-    std::cout << i << " vCPU " << event->vcpu_id << " hit breakpoint __x64_sys_write @ " << event->interrupt_event.gla << std::endl;
+  writeBp = reg.setBreakpoint(addrWrite, [&i, &loop, &disableWrite, &symbols](vmi_event_t *event) {
+    std::cout << i << " vCPU " << event->vcpu_id << " hit breakpoint __x64_sys_write @ " << symbols.describe(event->interrupt_event.gla) << std::endl;
     if (++i == 10) {
       loop.schedulePause(disableWrite, "breakpoint __x64_sys_write");
     }
   });
   writeBp->enable();
-  reg.setBreakpoint(addrRead, [&j, &loop, &stopLoop](vmi_event_t *event) {
-    std::cout << j << " vCPU " << event->vcpu_id << " hit breakpoint __x64_sys_read @ " << event->interrupt_event.gla << std::endl;
+  reg.setBreakpoint(addrRead, [&j, &loop, &stopLoop, &symbols](vmi_event_t *event) {
+    std::cout << j << " vCPU " << event->vcpu_id << " hit breakpoint __x64_sys_read @ " << symbols.describe(event->interrupt_event.gla) << std::endl;
     if (++j == 20) {
       loop.schedulePause(stopLoop, "breakpoint __x64_sys_read");
     }
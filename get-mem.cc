@@ -1,4 +1,6 @@
 #include <iostream>
+#include <vector>
+#include <algorithm>
 
 #include <libvmi/libvmi.h>
 #include <libvmi/events.h>
@@ -6,6 +8,8 @@
 #include <guestutil/VM.hh>
 #include <guestutil/mem.hh>
 #include <guestutil/mem/layout.hh>
+#include <guestutil/mem/ParallelScanner.hh>
+#include <guestutil/mem/dump.hh>
 
 #include <debug.hh>
 
@@ -15,24 +19,29 @@ using namespace guestutil;
 
 template <bool verbose>
 void printRange(vmi_instance_t vmi, memory::layout::VirtRange &range) {
-  int i = 0;
-  int mapped = 0;
-  range.forEachPageNum([vmi, &i, &mapped](addr_t pageNum) {
-    memory::translation::PageNum pn(pageNum);
-    try {
-      auto gfn = pn.toGFN(vmi);
-      if (verbose) std::cout << F_DEC(i) << '\t' << pn.toVirtAddr() << " => " << gfn << std::endl;
-      mapped++;
-    } catch (std::exception &e) {
-      ;  // Do nothing
-    }
-    i++;
+  addr_t startPage = range.getStartPageNum();
+  memory::layout::MappedExtents extents(vmi, range);
+  if (verbose) extents.forEachExtent([startPage](const memory::layout::MappedExtents::Extent &extent) {
+    addr_t pageNum = memory::glaToPageNum(extent.va);
+    std::cout << F_DEC(pageNum - startPage) << '\t' << memory::translation::VirtAddr(extent.va) << " => " << memory::translation::GFN(extent.gfn) << " (" << F_DEC(extent.pages) << " page(s))" << std::endl;
     return false;
   });
-  std::cout << "Mapped pages: " << F_DEC(mapped) << std::endl;
+  std::cout << "Mapped pages: " << F_DEC(extents.getMappedPages()) << " in " << F_DEC(extents.getExtents().size()) << " extent(s)" << std::endl;
 }
 
-int main() {
+void printNonZeroPages(vmi_instance_t vmi, memory::layout::VirtRange &range) {
+  memory::ParallelScanner scanner;
+  std::vector<addr_t> nonZero(scanner.getThreads());
+  scanner.scan(vmi, range, [&nonZero](unsigned int worker, addr_t, addr_t, const uint8_t *page) {
+    if (std::any_of(page, page + memory::PageView::pageSize, [](uint8_t byte) { return byte; })) nonZero[worker]++;
+    return false;
+  });
+  addr_t total = 0;
+  for (addr_t n : nonZero) total += n;
+  std::cout << "Non-zero pages: " << F_DEC(total) << " (" << F_DEC(scanner.getThreads()) << " thread(s))" << std::endl;
+}
+
+int main(int argc, char **argv) {
   vm::VM vm("debian11", VMI_INIT_EVENTS);
   std::cout << "VMI initialized." << std::endl;
 
@@ -70,6 +79,19 @@ int main() {
   memory::layout::VirtRange modules(0xffffffffa0000000ull, 0xfffffffffeffffffull + 1, nullptr);
   printRange<true>(vmi, text);
   printRange<true>(vmi, modules);
+  printNonZeroPages(vmi, text);
+  printNonZeroPages(vmi, modules);
+  if (argc > 1) {
+    std::cout << "Dumping guest memory to " << argv[1] << std::endl;
+    auto stats = memory::dump::dumpMemory(vmi, argv[1]);
+    std::cout << "Dumped frames: " << F_DEC(stats.frames) << " (" << F_DEC(stats.dataPages) << " non-zero, " << F_DEC(stats.skipped) << " skipped)" << std::endl;
+    memory::dump::DumpFile dump(argv[1]);
+    std::cout << "init_task in dump: " << (dump.read<addr_t>(kva) == memory::readAddrKVA(vmi, kva) ? "OK" : "MISMATCH") << std::endl;
+    if (argc > 2) {
+      std::cout << "Writing the raw view of the dump to " << argv[2] << std::endl;
+      dump.writeRaw(argv[2]);
+    }
+  }
   // In case the lookup triggers events?
   std::cout << "Pending events: " << vmi_are_events_pending(vmi) << std::endl;
 
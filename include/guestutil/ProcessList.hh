@@ -4,50 +4,177 @@
 #include <libvmi/libvmi.h>
 #include <guestutil/List.hh>
 #include <guestutil/mem.hh>
+#include <guestutil/mem/StructSnapshot.hh>
+#include <guestutil/mem/KernelStruct.hh>
+#include <guestutil/mem/Prefetcher.hh>
 #include <guestutil/symbol.hh>
-#include <guestutil/offset.hh>
+#include <guestutil/offset/OffsetTable.hh>
 #include <string>
+#include <string_view>
 
 
 namespace guestutil {
 namespace process {
 
+/**
+ * @brief The `task_struct` fields we use.
+ * 
+ */
+namespace task {
+
+
+/**
+ * @brief `TASK_COMM_LEN` of the Linux kernel (include/linux/sched.h).
+ * 
+ */
+constexpr size_t commLen = 16;
+
+struct tasks: memory::Field<addr_t, offset::LINUX_TASKS> {};
+struct comm: memory::StrField<commLen, offset::LINUX_NAME> {};
+struct pid: memory::Field<vmi_pid_t, offset::LINUX_PID> {};
+struct realParent: memory::Field<addr_t, offset::LINUX_REAL_PARENT> {};
+
+using TaskStruct = memory::KernelStruct<tasks, comm, pid>;
+using TaskStructWithParent =
+  memory::KernelStruct<tasks, comm, pid, realParent>;
+
+
+}
+
 class ProcessList: public list::List {
+public:
+  static constexpr size_t commLen = task::commLen;
 protected:
-  addr_t nameOffset;
-  addr_t pidOffset;
+  task::TaskStruct taskStruct;
 public:
   ProcessList() = default;
   ProcessList(addr_t initTask,
-    addr_t tasksOffset, addr_t _nameOffset, addr_t _pidOffset)
+    addr_t tasksOffset, addr_t nameOffset, addr_t pidOffset)
       :guestutil::list::List(initTask + tasksOffset, tasksOffset),
-        nameOffset(_nameOffset), pidOffset(_pidOffset) {};
+        taskStruct({tasksOffset, nameOffset, pidOffset}) {};
 
   static inline ProcessList fromVMI(vmi_instance_t vmi) {
     addr_t initTaskAddr = symbol::translateKernelSymbol(vmi, "init_task");
-    addr_t tasksOffset = offset::getOffset(vmi, "linux_tasks");
-    addr_t nameOffset = offset::getOffset(vmi, "linux_name");
-    addr_t pidOffset = offset::getOffset(vmi, "linux_pid");
-    ProcessList list(initTaskAddr, tasksOffset, nameOffset, pidOffset);
+    task::TaskStruct taskStruct = task::TaskStruct::of(vmi);
+    ProcessList list(
+      initTaskAddr, taskStruct.offsetOf<task::tasks>(),
+      taskStruct.offsetOf<task::comm>(), taskStruct.offsetOf<task::pid>());
     return list;
   }
 
+  inline const task::TaskStruct &getTaskStruct() const {
+    return taskStruct;
+  }
+
   inline addr_t getNameOffset() {
-    return nameOffset;
+    return taskStruct.offsetOf<task::comm>();
   }
 
   inline addr_t getPidOffset() {
-    return pidOffset;
+    return taskStruct.offsetOf<task::pid>();
   }
 
   inline std::string name(vmi_instance_t vmi, list::ListItem &proc) {
     addr_t nameAddr = getMemberAddr(proc, getNameOffset());
-    return memory::readCppStrKVA(vmi, nameAddr);
+    char comm[commLen];
+    return std::string(memory::readStrKVA(vmi, nameAddr, comm));
   }
 
   inline vmi_pid_t pid(vmi_instance_t vmi, list::ListItem &proc) {
-    addr_t pidAddr = getMemberAddr(proc, getPidOffset());
-    return memory::read32KVA<vmi_pid_t>(vmi, pidAddr);
+    return taskStruct.read<task::pid>(vmi, getObjectAddr(proc));
+  }
+
+  /**
+   * @brief Get the layout covering the `task_struct` fields we use, i.e.,
+   * `tasks.next`, `comm` and `pid`.
+   * 
+   * @return memory::StructLayout 
+   */
+  inline memory::StructLayout getTaskLayout() {
+    return taskStruct.getLayout();
+  }
+
+  inline std::string_view name(const memory::StructSnapshot &task) {
+    return task.getStr(getNameOffset(), commLen);
+  }
+
+  inline vmi_pid_t pid(const memory::StructSnapshot &task) {
+    return task.get<vmi_pid_t>(getPidOffset());
+  }
+
+  inline list::ListItem next(const memory::StructSnapshot &task) {
+    return list::ListItem::fromAddr(task.get<addr_t>(getListHeadOffset()));
+  }
+
+  inline std::string_view name(const task::TaskStruct::Snapshot &snapshot) {
+    return snapshot.get<task::comm>();
+  }
+
+  inline vmi_pid_t pid(const task::TaskStruct::Snapshot &snapshot) {
+    return snapshot.get<task::pid>();
+  }
+
+  inline list::ListItem next(const task::TaskStruct::Snapshot &snapshot) {
+    return list::ListItem::fromAddr(snapshot.get<task::tasks>());
+  }
+
+  /**
+   * @brief Like `forEach`, but read each `task_struct` (see `getTaskLayout`)
+   * with one guest read, including the pointer to the next task. Stop when
+   * `action` returns `true`.
+   * 
+   * The next task is prefetched (see `memory::Prefetcher`) before `action` is
+   * called, so it can be fetched while `action` runs. The prefetch is
+   * cancelled if `action` stops the walk.
+   * 
+   * @tparam F callback function type,
+   * `bool (list::ListItem currentItem, const task::TaskStruct::Snapshot &task)`
+   * (a `memory::StructSnapshot`). The snapshot is only valid during the
+   * callback.
+   * @param vmi 
+   * @param action 
+   */
+  template<typename F>
+  inline void forEachSnapshot(vmi_instance_t vmi, F action) {
+    forEachSnapshot(vmi, taskStruct, action);
+  }
+
+  /**
+   * @brief Like `forEachSnapshot`, but read the fields of `desc` (which must
+   * include `task::tasks`, at the same offset as this list).
+   * 
+   * @tparam Desc a `memory::KernelStruct`.
+   * @tparam F callback function type,
+   * `bool (list::ListItem currentItem, const Desc::Snapshot &task)`.
+   * @param vmi 
+   * @param desc 
+   * @param action 
+   */
+  template<typename Desc, typename F>
+  inline void forEachSnapshot(vmi_instance_t vmi, const Desc &desc, F action) {
+    const memory::StructLayout &layout = desc.getLayout();
+    auto nextOf = [](const typename Desc::Snapshot &snapshot) {
+      return list::ListItem::fromAddr(
+        snapshot.template get<task::tasks>());
+    };
+    typename Desc::Snapshot current(desc);
+    for (
+      list::ListItem pos = getFirst().next(vmi);
+      pos != getFirst();
+      pos = nextOf(current)
+    ) {
+      current.read(vmi, getObjectAddr(pos));
+      list::ListItem nextPos = nextOf(current);
+      if (nextPos != getFirst()) {
+        memory::prefetch(
+          vmi, getObjectAddr(nextPos) + layout.getBegin(), layout.getSpan());
+      }
+      if (action(pos, current)) {
+        // Do not leave the prefetch of the next task in flight
+        memory::cancelPrefetch(vmi);
+        break;
+      }
+    }
   }
 };
 
@@ -0,0 +1,348 @@
+/**
+ * @file ProcessSnapshot.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Column-wise snapshot of the process list with a PID index.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef C7A2E9F5_3D18_4B64_A0C7_9E5F1B8D2A46
+#define C7A2E9F5_3D18_4B64_A0C7_9E5F1B8D2A46
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/ProcessList.hh>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/KernelStruct.hh>
+#include <guestutil/offset/OffsetTable.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <array>  // std::array
+#include <unordered_map>  // std::unordered_map
+#include <string_view>  // std::string_view
+#include <type_traits>  // std::is_same
+#include <cstring>  // std::memcpy, std::memchr
+#include <cstdint>
+
+
+namespace guestutil {
+namespace process {
+
+
+/**
+ * @brief Snapshot of all the tasks of a `ProcessList` (including `init_task`),
+ * stored column-wise (task addresses, PIDs, comms, parents), with an
+ * open-addressing hash table from PID to row, so that PID to task and PID to
+ * comm lookups are O(1) and never touch the guest.
+ * 
+ * Each task is read with one guest read (see `ProcessList::forEachSnapshot`).
+ * Parents are only known if the `offset::LINUX_REAL_PARENT` offset is (e.g.,
+ * from a profile, see `offset::OffsetTable::fromFile`). Like
+ * `memory::PageHashSnapshot`, a snapshot is tagged with the epoch of the
+ * page cache and is meant to be taken once per pause (see `isStale` and
+ * `update`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * vm.pause();
+ * process::ProcessSnapshot procs(vmi, procList);
+ * // In an event callback
+ * uint32_t row = procs.findRow(pid);
+ * if (row != process::ProcessSnapshot::npos) {
+ *   std::cout << procs.getComm(row) << std::endl;
+ * }
+ * ```
+ * 
+ */
+class ProcessSnapshot {
+public:
+  /**
+   * @brief Row of an absent task.
+   * 
+   */
+  static constexpr uint32_t npos = ~uint32_t(0);
+  using Comm = std::array<char, task::commLen>;
+private:
+  struct Slot {
+    vmi_pid_t pid;
+    /**
+     * @brief `npos` if the slot is empty.
+     * 
+     */
+    uint32_t row;
+  };
+
+  std::vector<addr_t> tasks;
+  std::vector<vmi_pid_t> pids;
+  std::vector<Comm> comms;
+  /**
+   * @brief `task_struct` address of the parent of each task, 0 if unknown.
+   * 
+   */
+  std::vector<addr_t> parents;
+  std::vector<uint32_t> parentRows;
+  /**
+   * @brief PID to row (power-of-2 size, linear probing).
+   * 
+   */
+  std::vector<Slot> slots;
+  unsigned int slotShift;
+  bool hasParents;
+  uint64_t epoch;
+
+  inline size_t slotOf(vmi_pid_t pid) const {
+    // Fibonacci hashing, keeping the top bits
+    return (uint64_t(uint32_t(pid)) * 0x9e3779b97f4a7c15ull) >> slotShift;
+  }
+
+  template <typename Snapshot>
+  inline void append(addr_t taskAddr, const Snapshot &snapshot) {
+    tasks.push_back(taskAddr);
+    pids.push_back(snapshot.template get<task::pid>());
+    std::string_view comm = snapshot.template get<task::comm>();
+    Comm &dest = comms.emplace_back();
+    dest.fill('\0');
+    std::memcpy(dest.data(), comm.data(), comm.size());
+  }
+
+  /**
+   * @brief Walk `list` reading the fields of `desc`.
+   * 
+   */
+  template <typename Desc>
+  inline void collect(vmi_instance_t vmi, ProcessList &list, const Desc &desc) {
+    constexpr bool withParent = std::is_same<
+      Desc, task::TaskStructWithParent>::value;
+    typename Desc::Snapshot initTask(desc);
+    list::ListItem first = list.getFirst();
+    addr_t initTaskAddr = list.getObjectAddr(first);
+    initTask.read(vmi, initTaskAddr);
+    auto add = [this](addr_t taskAddr, const auto &snapshot) {
+      append(taskAddr, snapshot);
+      if constexpr (withParent) {
+        parents.push_back(snapshot.template get<task::realParent>());
+      } else {
+        parents.push_back(0);
+      }
+    };
+    add(initTaskAddr, initTask);
+    using Snapshot = typename Desc::Snapshot;
+    list.forEachSnapshot(vmi, desc,
+      [&list, &add](list::ListItem pos, const Snapshot &snapshot) {
+        add(list.getObjectAddr(pos), snapshot);
+        return false;
+      });
+  }
+
+  inline void index() {
+    size_t n = tasks.size();
+    size_t size = 2;
+    slotShift = 63;
+    while (size < 2 * n) {
+      size <<= 1;
+      slotShift--;
+    }
+    slots.assign(size, Slot{0, npos});
+    size_t mask = size - 1;
+    for (uint32_t row = 0; row < n; row++) {
+      for (size_t i = slotOf(pids[row]);; i = (i + 1) & mask) {
+        if (slots[i].row == npos) {
+          slots[i] = Slot{pids[row], row};
+          break;
+        }
+        if (slots[i].pid == pids[row]) break;  // Keep the first one
+      }
+    }
+    // Parent pointers to rows, once
+    parentRows.assign(n, npos);
+    if (!hasParents) return;
+    std::unordered_map<addr_t, uint32_t> rows;
+    rows.reserve(n);
+    for (uint32_t row = 0; row < n; row++) rows.emplace(tasks[row], row);
+    for (uint32_t row = 0; row < n; row++) {
+      auto it = rows.find(parents[row]);
+      if (it != rows.end()) parentRows[row] = it->second;
+    }
+  }
+public:
+  ProcessSnapshot():
+    tasks(), pids(), comms(), parents(), parentRows(), slots(), slotShift(63),
+    hasParents(false), epoch(0) {};
+
+  /**
+   * @brief Take a snapshot of `list`.
+   * 
+   * @param vmi
+   * @param list
+   */
+  ProcessSnapshot(vmi_instance_t vmi, ProcessList &list): ProcessSnapshot() {
+    rebuild(vmi, list);
+  }
+
+  /**
+   * @brief Take a new snapshot of `list`, replacing the current one.
+   * 
+   * The new snapshot is built aside, so if a read throws, the current one is
+   * kept as is (and still stale, see `update`).
+   * 
+   * @param vmi
+   * @param list
+   */
+  inline void rebuild(vmi_instance_t vmi, ProcessList &list) {
+    ProcessSnapshot next;
+    uint64_t nextEpoch = memory::PageCache::of(vmi).getEpoch();
+    addr_t parentOffset = 0;
+    next.hasParents = offset::OffsetTable::of(vmi).tryGet(
+      offset::LINUX_REAL_PARENT, parentOffset) == VMI_SUCCESS;
+    if (next.hasParents) {
+      next.collect(vmi, list, task::TaskStructWithParent({
+        list.getListHeadOffset(), list.getNameOffset(), list.getPidOffset(),
+        parentOffset
+      }));
+    } else {
+      next.collect(vmi, list, list.getTaskStruct());
+    }
+    next.index();
+    next.epoch = nextEpoch;
+    *this = std::move(next);
+    DBG() << "ProcessSnapshot.rebuild(): " << F_DEC(tasks.size())
+          << " task(s)" << std::endl;
+  }
+
+  inline bool isStale(vmi_instance_t vmi) const {
+    return epoch != memory::PageCache::of(vmi).getEpoch();
+  }
+
+  /**
+   * @brief Take a new snapshot if the current one is stale.
+   * 
+   * @param vmi
+   * @param list
+   * @return bool if a new snapshot is taken.
+   */
+  inline bool update(vmi_instance_t vmi, ProcessList &list) {
+    if (!isStale(vmi)) return false;
+    rebuild(vmi, list);
+    return true;
+  }
+
+  /**
+   * @brief Get the number of tasks (rows).
+   * 
+   * @return size_t
+   */
+  inline size_t size() const {
+    return tasks.size();
+  }
+
+  inline bool hasParentInfo() const {
+    return hasParents;
+  }
+
+  /**
+   * @brief Find the row of the task of PID `pid`.
+   * 
+   * @param pid
+   * @return uint32_t `npos` if absent.
+   */
+  inline uint32_t findRow(vmi_pid_t pid) const {
+    if (slots.empty()) return npos;  // Default-constructed
+    size_t mask = slots.size() - 1;
+    for (size_t i = slotOf(pid);; i = (i + 1) & mask) {
+      const Slot &slot = slots[i];
+      if (slot.row == npos || slot.pid == pid) return slot.row;
+    }
+  }
+
+  inline addr_t getTask(uint32_t row) const {
+    return tasks[row];
+  }
+
+  inline vmi_pid_t getPid(uint32_t row) const {
+    return pids[row];
+  }
+
+  inline std::string_view getComm(uint32_t row) const {
+    const Comm &comm = comms[row];
+    const void *nul = std::memchr(comm.data(), 0, comm.size());
+    return std::string_view(
+      comm.data(),
+      nul ? reinterpret_cast<const char *>(nul) - comm.data() : comm.size());
+  }
+
+  /**
+   * @brief Get the `task_struct` address of the parent of the task at `row`.
+   * 
+   * @param row
+   * @return addr_t 0 if unknown (see `hasParentInfo`).
+   */
+  inline addr_t getParent(uint32_t row) const {
+    return parents[row];
+  }
+
+  /**
+   * @brief Get the row of the parent of the task at `row`.
+   * 
+   * @param row
+   * @return uint32_t `npos` if unknown or not in the snapshot.
+   */
+  inline uint32_t getParentRow(uint32_t row) const {
+    return parentRows[row];
+  }
+
+  /**
+   * @brief Get the `task_struct` address of the task of PID `pid`.
+   * 
+   * @param[in] pid
+   * @param[out] task
+   * @return status_t
+   */
+  inline status_t tryFindTask(vmi_pid_t pid, addr_t &task) const {
+    uint32_t row = findRow(pid);
+    if (row == npos) return VMI_FAILURE;
+    task = tasks[row];
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Get the comm of the task of PID `pid`.
+   * 
+   * @param[in] pid
+   * @param[out] comm valid until the next `rebuild`.
+   * @return status_t
+   */
+  inline status_t tryGetComm(vmi_pid_t pid, std::string_view &comm) const {
+    uint32_t row = findRow(pid);
+    if (row == npos) return VMI_FAILURE;
+    comm = getComm(row);
+    return VMI_SUCCESS;
+  }
+
+  inline const std::vector<addr_t> &getTasks() const {
+    return tasks;
+  }
+
+  inline const std::vector<vmi_pid_t> &getPids() const {
+    return pids;
+  }
+
+  inline const std::vector<Comm> &getComms() const {
+    return comms;
+  }
+
+  inline const std::vector<addr_t> &getParents() const {
+    return parents;
+  }
+};
+
+
+}
+}
+
+
+#endif /* C7A2E9F5_3D18_4B64_A0C7_9E5F1B8D2A46 */
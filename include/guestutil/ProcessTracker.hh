@@ -0,0 +1,429 @@
+/**
+ * @file ProcessTracker.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Process table kept up to date by breakpoints instead of list walks.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef D4B8E1A6_5C29_4F73_8A0E_3B7C6D9F1E52
+#define D4B8E1A6_5C29_4F73_8A0E_3B7C6D9F1E52
+
+
+#include <libvmi/libvmi.h>
+#include <libvmi/events.h>
+
+#include <guestutil/ProcessList.hh>
+#include <guestutil/mem.hh>
+#include <guestutil/symbol/SymbolCache.hh>
+#include <guestutil/breakpoint/Breakpoint.hh>
+#include <guestutil/breakpoint/BreakpointRegistry.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <vector>  // std::vector
+#include <array>  // std::array
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <functional>  // std::function
+#include <algorithm>  // std::fill
+#include <exception>
+#include <cstring>  // std::memcpy, std::memchr
+#include <cstdint>
+
+
+namespace guestutil {
+namespace process {
+
+
+class ProcessTrackerError: public std::exception {
+public:
+  std::string msg;
+  ProcessTrackerError(const std::string &_msg): msg(_msg) {};
+  const char *what() const throw() {
+    return msg.c_str();
+  }
+};
+
+/**
+ * @brief A task known to `ProcessTracker`.
+ * 
+ */
+struct TrackedTask {
+  /**
+   * @brief `task_struct` address.
+   * 
+   */
+  addr_t task;
+  vmi_pid_t pid;
+  std::array<char, task::commLen> comm;
+
+  inline std::string_view getComm() const {
+    const void *nul = std::memchr(comm.data(), 0, comm.size());
+    return std::string_view(
+      comm.data(),
+      nul ? reinterpret_cast<const char *>(nul) - comm.data() : comm.size());
+  }
+};
+
+enum class TaskChange {
+  CREATED,
+  EXITED,
+  /**
+   * @brief The comm has changed (e.g., on `execve`).
+   * 
+   */
+  RENAMED
+};
+
+/**
+ * @brief Process table (the tasks of `ProcessList`, i.e., the thread group
+ * leaders, including `init_task`) built with one walk of the list and then
+ * kept up to date by breakpoints (see `breakpoint::BreakpointRegistry`) on the
+ * task creation and release paths of the guest kernel:
+ * 
+ * - `wake_up_new_task(p)`: a new task is about to run (already in the list);
+ * - `release_task(p)`: a dead task is reaped (removed from the list), or the
+ *   old leader is released after a non-leader thread exec'd (`de_thread`),
+ *   in which case the process is moved to the `task_struct` of that thread;
+ * - `__set_task_comm(tsk, buf, exec)`: the comm changes (optional, tracked if
+ *   the symbol exists).
+ * 
+ * `release_task` is hooked instead of `do_exit` because it takes the task as
+ * argument (`do_exit` runs on `current`) and is where the task leaves the list.
+ * 
+ * Queries are local lookups and never read the guest nor pause it. The
+ * callbacks run on the event loop thread, so the tracker, like
+ * `event::Loop`, is not thread-safe. If an update cannot be read from the
+ * guest, it is counted in `Stats::missed` and `resync` can be used (e.g., in a
+ * `event::Loop::schedulePause` callback) to walk the list again.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * breakpoint::BreakpointRegistry reg(vmi);
+ * reg.registerEvent();
+ * vm.pause();
+ * process::ProcessTracker tracker(vmi, procList, reg);
+ * tracker.start();
+ * vm.resume();
+ * // In any event callback
+ * std::string_view comm;
+ * if (tracker.tryGetComm(pid, comm) == VMI_SUCCESS) std::cout << comm;
+ * ```
+ * 
+ */
+class ProcessTracker {
+public:
+  using Listener = std::function<void(TaskChange, const TrackedTask &)>;
+
+  /**
+   * @brief Tracker statistics.
+   * 
+   */
+  struct Stats {
+    size_t created;
+    size_t exited;
+    size_t renamed;
+    /**
+     * @brief Updates that could not be read from the guest.
+     * 
+     */
+    size_t missed;
+  };
+private:
+  vmi_instance_t vmi;
+  ProcessList list;
+  breakpoint::BreakpointRegistry &reg;
+  std::unordered_map<vmi_pid_t, TrackedTask> tasks;
+  /**
+   * @brief `task_struct` address to PID, for `release_task`.
+   * 
+   */
+  std::unordered_map<addr_t, vmi_pid_t> pids;
+  /**
+   * @brief Addresses of the breakpoints set by `start`.
+   * 
+   */
+  std::vector<addr_t> hooks;
+  Listener listener;
+  Stats stats;
+
+  inline void add(addr_t taskAddr, const task::TaskStruct::Snapshot &snapshot) {
+    TrackedTask entry{taskAddr, snapshot.get<task::pid>(), {}};
+    std::string_view comm = snapshot.get<task::comm>();
+    std::memcpy(entry.comm.data(), comm.data(), comm.size());
+    // A reused PID replaces the previous task
+    auto it = tasks.find(entry.pid);
+    if (it != tasks.end()) pids.erase(it->second.task);
+    tasks[entry.pid] = entry;
+    pids[taskAddr] = entry.pid;
+  }
+
+  inline void notify(TaskChange change, const TrackedTask &entry) {
+    if (listener) listener(change, entry);
+  }
+
+  /**
+   * @brief Get the `task_struct` address linked before the `tasks` entry
+   * `next`, i.e., `container_of(next->prev, struct task_struct, tasks)`.
+   * 
+   */
+  inline addr_t linkedBefore(addr_t next) {
+    addr_t nextPrev = 0;
+    if (memory::tryReadAddrKVA(
+          vmi, next + vmi_get_address_width(vmi), nextPrev) == VMI_FAILURE) {
+      throw memory::MemoryReadError(next, memory::READ_ADDR_KVA);
+    }
+    return nextPrev - list.getListHeadOffset();
+  }
+
+  /**
+   * @brief If the task at `taskAddr` is linked in the list, i.e., it is a
+   * thread group leader (other threads are never linked).
+   * 
+   */
+  inline bool isLinked(
+    addr_t taskAddr, const task::TaskStruct::Snapshot &snapshot
+  ) {
+    return linkedBefore(snapshot.get<task::tasks>()) == taskAddr;
+  }
+
+  inline void onNewTask(vmi_event_t *event) {
+    addr_t taskAddr = event->x86_regs->rdi;
+    task::TaskStruct::Snapshot snapshot(list.getTaskStruct());
+    snapshot.read(vmi, taskAddr);
+    if (!isLinked(taskAddr, snapshot)) return;  // A thread
+    add(taskAddr, snapshot);
+    stats.created++;
+    notify(TaskChange::CREATED, tasks[snapshot.get<task::pid>()]);
+  }
+
+  inline void onReleaseTask(vmi_event_t *event) {
+    addr_t taskAddr = event->x86_regs->rdi;
+    auto it = pids.find(taskAddr);
+    if (it == pids.end()) return;  // A thread
+    auto taskIt = tasks.find(it->second);
+    if (taskIt == tasks.end() || taskIt->second.task != taskAddr) {
+      pids.erase(it);
+      return;
+    }
+    // An exiting task is still linked when released. If not, a non-leader
+    // thread has exec'd (`de_thread`): it took over the PID and the list
+    // slot of the leader, which is released, so the process lives on.
+    addr_t next = 0;
+    if (memory::tryReadAddrKVA(
+          vmi, taskAddr + list.getListHeadOffset(), next) == VMI_FAILURE) {
+      throw memory::MemoryReadError(
+        taskAddr + list.getListHeadOffset(), memory::READ_ADDR_KVA);
+    }
+    addr_t successor = linkedBefore(next);
+    pids.erase(it);
+    if (successor != taskAddr) {
+      taskIt->second.task = successor;
+      pids[successor] = taskIt->first;
+      DBG() << "ProcessTracker: PID " << taskIt->first << " moved to "
+            << F_PTR(successor) << std::endl;
+      return;
+    }
+    TrackedTask entry = taskIt->second;
+    tasks.erase(taskIt);
+    stats.exited++;
+    notify(TaskChange::EXITED, entry);
+  }
+
+  inline void onSetComm(vmi_event_t *event) {
+    auto it = pids.find(event->x86_regs->rdi);
+    if (it == pids.end()) return;
+    TrackedTask &entry = tasks[it->second];
+    std::array<char, task::commLen> comm{};
+    // Same as the kernel: at most `commLen - 1` characters, NUL-padded
+    memory::readKVA(vmi, event->x86_regs->rsi, comm.size() - 1, comm.data());
+    const void *nul = std::memchr(comm.data(), 0, comm.size());
+    size_t len = nul ? reinterpret_cast<const char *>(nul) - comm.data()
+                     : comm.size() - 1;
+    std::fill(comm.begin() + len, comm.end(), '\0');
+    entry.comm = comm;
+    stats.renamed++;
+    notify(TaskChange::RENAMED, entry);
+  }
+
+  /**
+   * @brief Wrap `handler` so that failed guest reads are counted instead of
+   * propagated to LibVMI.
+   * 
+   */
+  inline std::function<void(vmi_event_t*)> guarded(
+    void (ProcessTracker::*handler)(vmi_event_t*)
+  ) {
+    return [this, handler](vmi_event_t *event) {
+      try {
+        (this->*handler)(event);
+      } catch (memory::MemoryReadError &err) {
+        stats.missed++;
+        DBG() << "ProcessTracker: missed an update: " << err.what()
+              << std::endl;
+      }
+    };
+  }
+
+  inline void hook(
+    const char *name, void (ProcessTracker::*handler)(vmi_event_t*),
+    bool required
+  ) {
+    addr_t addr = 0;
+    if (symbol::SymbolCache::of(vmi).tryTranslate(name, addr) ==
+        VMI_FAILURE) {
+      if (required) {
+        throw ProcessTrackerError(std::string("Cannot hook ") + name);
+      }
+      DBG() << "ProcessTracker: " << name << " not found, not tracked"
+            << std::endl;
+      return;
+    }
+    reg.setBreakpoint(addr, guarded(handler))->enable();
+    hooks.push_back(addr);
+  }
+public:
+  ProcessTracker(
+    vmi_instance_t _vmi, const ProcessList &_list,
+    breakpoint::BreakpointRegistry &_reg
+  ):
+    vmi(_vmi), list(_list), reg(_reg), tasks(), pids(), hooks(), listener(),
+    stats{0, 0, 0, 0} {};
+
+  ProcessTracker(const ProcessTracker &) = delete;
+  ProcessTracker &operator=(const ProcessTracker &) = delete;
+
+  /**
+   * @brief Walk the list once and set the breakpoints. The guest must be
+   * paused, and the breakpoint event of `reg` registered.
+   * 
+   */
+  inline void start() {
+    if (!hooks.empty()) return;
+    resync();
+    try {
+      hook("wake_up_new_task", &ProcessTracker::onNewTask, true);
+      hook("release_task", &ProcessTracker::onReleaseTask, true);
+      hook("__set_task_comm", &ProcessTracker::onSetComm, false);
+    } catch (...) {
+      stop();
+      throw;
+    }
+    DBG() << "ProcessTracker.start(): " << F_DEC(tasks.size())
+          << " task(s), " << F_DEC(hooks.size()) << " hook(s)" << std::endl;
+  }
+
+  /**
+   * @brief Unset the breakpoints. Like `breakpoint::Breakpoint::disable`, the
+   * guest must be paused and the events drained (see
+   * `event::Loop::schedulePause`). Must be called before the tracker is
+   * destroyed if `reg` outlives it.
+   * 
+   */
+  inline void stop() {
+    for (addr_t addr : hooks) reg.unsetBreakpoint(addr);
+    hooks.clear();
+  }
+
+  inline bool isStarted() const {
+    return !hooks.empty();
+  }
+
+  /**
+   * @brief Rebuild the table by walking the list. The guest must be paused.
+   * 
+   */
+  inline void resync() {
+    tasks.clear();
+    pids.clear();
+    task::TaskStruct::Snapshot initTask(list.getTaskStruct());
+    list::ListItem first = list.getFirst();
+    addr_t initTaskAddr = list.getObjectAddr(first);
+    initTask.read(vmi, initTaskAddr);
+    add(initTaskAddr, initTask);
+    list.forEachSnapshot(vmi,
+      [this](list::ListItem pos, const task::TaskStruct::Snapshot &snapshot) {
+        add(list.getObjectAddr(pos), snapshot);
+        return false;
+      });
+  }
+
+  /**
+   * @brief Call `_listener` on every change (from the event loop thread).
+   * 
+   * @param _listener
+   */
+  inline void setListener(Listener _listener) {
+    listener = _listener;
+  }
+
+  inline size_t size() const {
+    return tasks.size();
+  }
+
+  inline Stats getStats() const {
+    return stats;
+  }
+
+  /**
+   * @brief Find the task of PID `pid`.
+   * 
+   * @param pid
+   * @return const TrackedTask* `nullptr` if absent, valid until the next
+   * change.
+   */
+  inline const TrackedTask *find(vmi_pid_t pid) const {
+    auto it = tasks.find(pid);
+    return it == tasks.end() ? nullptr : &it->second;
+  }
+
+  /**
+   * @brief Get the `task_struct` address of the task of PID `pid`.
+   * 
+   * @param[in] pid
+   * @param[out] task
+   * @return status_t
+   */
+  inline status_t tryFindTask(vmi_pid_t pid, addr_t &task) const {
+    const TrackedTask *entry = find(pid);
+    if (!entry) return VMI_FAILURE;
+    task = entry->task;
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Get the comm of the task of PID `pid`.
+   * 
+   * @param[in] pid
+   * @param[out] comm valid until the next change.
+   * @return status_t
+   */
+  inline status_t tryGetComm(vmi_pid_t pid, std::string_view &comm) const {
+    const TrackedTask *entry = find(pid);
+    if (!entry) return VMI_FAILURE;
+    comm = entry->getComm();
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Call `action` on every tracked task (in no particular order).
+   * 
+   * @tparam F callback function type, `void (const TrackedTask &task)`.
+   * @param action
+   */
+  template <typename F>
+  inline void forEach(F action) const {
+    for (auto &it : tasks) action(it.second);
+  }
+};
+
+
+}
+}
+
+
+#endif /* D4B8E1A6_5C29_4F73_8A0E_3B7C6D9F1E52 */
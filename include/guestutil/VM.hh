@@ -3,6 +3,14 @@
 
 #include <libvmi/libvmi.h>
 #include <exception>
+#include <mutex>  // std::lock_guard
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/mem/ReverseMap.hh>
+#include <guestutil/symbol/SymbolCache.hh>
+#include <guestutil/symbol/SymbolIndex.hh>
+#include <guestutil/offset/OffsetTable.hh>
+#include <guestutil/VMILock.hh>
 #include <debug.hh>
 
 
@@ -89,6 +97,8 @@ public:
       this->initFlags = 0;
       throw VMIInitError(err);
     }
+    // Resolve the offsets once (see `offset::OffsetTable::use` to override)
+    offset::OffsetTable::of(vmi);
   }
 
   inline vmi_instance_t &getVMI() {
@@ -103,23 +113,48 @@ public:
     return getInitFlags() & VMI_INIT_EVENTS;
   }
 
+  /**
+   * @brief Pause the VM, flush the TLB (translations made while the guest
+   * ran may be stale) and enable the page cache (with a fresh epoch).
+   * 
+   */
   inline void pause() {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (vmi_pause_vm(vmi) == VMI_FAILURE) {
       throw PauseError();
     }
+    memory::TLB::of(vmi).flush();
+    memory::PageCache::of(vmi).enable();
   }
 
+  /**
+   * @brief Disable the page cache (invalidating it), flush the TLB and resume
+   * the VM.
+   * 
+   */
   inline void resume() {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    memory::PageCache::of(vmi).disable();
+    memory::TLB::of(vmi).flush();
     if (vmi_resume_vm(vmi) == VMI_FAILURE) {
       throw ResumeError();
     }
   }
 
   inline status_t tryPause() {
-    return vmi_pause_vm(vmi);
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    status_t status = vmi_pause_vm(vmi);
+    if (status == VMI_SUCCESS) {
+      memory::TLB::of(vmi).flush();
+      memory::PageCache::of(vmi).enable();
+    }
+    return status;
   }
 
   inline status_t tryResume() {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    memory::PageCache::of(vmi).disable();
+    memory::TLB::of(vmi).flush();
     return vmi_resume_vm(vmi);
   }
 
@@ -133,8 +168,18 @@ public:
 
   ~VM() {
     DBG() << "~VM()" << std::endl;
-    vmi_resume_vm(vmi);
-    vmi_destroy(vmi);
+    memory::PageCache::drop(vmi);
+    memory::TLB::drop(vmi);
+    memory::ReverseMap::drop(vmi);
+    symbol::SymbolCache::drop(vmi);
+    symbol::SymbolIndex::drop(vmi);
+    offset::OffsetTable::drop(vmi);
+    {
+      std::lock_guard<VMILock> guard(VMILock::of(vmi));
+      vmi_resume_vm(vmi);
+      vmi_destroy(vmi);
+    }
+    VMILock::drop(vmi);
     if (initData) {
       delete initData;
       initData = nullptr;
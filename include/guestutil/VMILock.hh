@@ -0,0 +1,150 @@
+/**
+ * @file VMILock.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Per `vmi_instance_t` lock serializing LibVMI calls across threads.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A7D3E91C_4B6F_4E28_8C15_9F2B6A0D3E47
+#define A7D3E91C_4B6F_4E28_8C15_9F2B6A0D3E47
+
+
+#include <libvmi/libvmi.h>
+
+#include <unordered_map>  // std::unordered_map
+#include <memory>  // std::unique_ptr
+#include <mutex>  // std::recursive_mutex
+#include <thread>  // std::thread, std::this_thread
+#include <atomic>  // std::atomic
+#include <cstddef>  // size_t
+
+
+namespace guestutil {
+
+
+/**
+ * @brief Per `vmi_instance_t` lock held around every LibVMI call made on
+ * `vmi` by this library, as LibVMI instances are not thread-safe and helper
+ * threads (see `memory::Prefetcher`) share `vmi` with the calling thread.
+ * 
+ * The lock is recursive, since LibVMI calls nest through the library (e.g.,
+ * a page cache miss translates through the `TLB`) and event callbacks run
+ * inside `vmi_events_listen`, under the lock. The read-only getters of the
+ * configuration of `vmi` (e.g., `vmi_get_address_width`, `vmi_get_offset`)
+ * are not guarded.
+ * Code calling LibVMI directly on `vmi` while a helper thread is alive takes
+ * the lock the same way:
+ * 
+ * ```C++
+ * {
+ *   std::lock_guard<VMILock> guard(VMILock::of(vmi));
+ *   vmi_read_pa(vmi, gpa, count, buff, &bytesRead);
+ * }
+ * ```
+ * 
+ */
+class VMILock {
+private:
+  std::recursive_mutex mutex;
+  /**
+   * @brief The thread holding the lock, if any.
+   * 
+   */
+  std::atomic<std::thread::id> owner;
+  /**
+   * @brief Times the owner has locked (guarded by `mutex`).
+   * 
+   */
+  size_t depth;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<VMILock>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` locks.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<VMILock>> locks;
+    return locks;
+  }
+
+  VMILock(): mutex(), owner(), depth(0) {}
+
+  VMILock(VMILock&) = delete;
+  VMILock(VMILock&&) = delete;
+public:
+  /**
+   * @brief Get the lock of `vmi` (created on first use). Only called on the
+   * thread owning `vmi`; helper threads keep the reference.
+   * 
+   * @param vmi
+   * @return VMILock&
+   */
+  static VMILock &of(vmi_instance_t vmi) {
+    auto &locks = registry();
+    auto it = locks.find(vmi);
+    if (it == locks.end()) {
+      it = locks.emplace(vmi, std::unique_ptr<VMILock>(new VMILock())).first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the lock of `vmi` (if any). Called before `vmi` is destroyed,
+   * after every helper thread has stopped.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  inline void lock() {
+    mutex.lock();
+    if (!depth++) owner = std::this_thread::get_id();
+  }
+
+  inline void unlock() {
+    if (!--depth) owner = std::thread::id();
+    mutex.unlock();
+  }
+
+  /**
+   * @brief If the calling thread holds the lock.
+   * 
+   * @return bool
+   */
+  inline bool isHeld() const {
+    return owner == std::this_thread::get_id();
+  }
+
+  /**
+   * @brief Fully release the lock if the calling thread holds it, e.g., to
+   * join a helper thread waiting for it from under an event callback.
+   * 
+   * @return size_t the number of times to `relock`.
+   */
+  inline size_t unlockAll() {
+    if (!isHeld()) return 0;
+    size_t n = depth;
+    for (size_t i = 0; i < n; i++) unlock();
+    return n;
+  }
+
+  /**
+   * @brief Undo `unlockAll`.
+   * 
+   * @param n
+   */
+  inline void relock(size_t n) {
+    while (n--) lock();
+  }
+};
+
+
+}
+
+
+#endif /* A7D3E91C_4B6F_4E28_8C15_9F2B6A0D3E47 */
@@ -19,11 +19,15 @@
 #include <functional>  // std::function
 #include <memory>  // std::shared_ptr
 #include <vector>  // std::vector
+#include <mutex>  // std::lock_guard
 #include <exception>
 
 #include <guestutil/mem.hh>
+#include <guestutil/mem/batch.hh>
+#include <guestutil/mem/PatchSet.hh>
 #include <guestutil/event/error.hh>
 #include <guestutil/event/data.hh>
+#include <guestutil/VMILock.hh>
 #include <debug.hh>
 #include <pretty-print.hh>
 
@@ -198,6 +202,7 @@ public:
     // Freed in `doAfterClearEvent`
     event->data = new event::EventData<BreakpointRegistry>(typeId, *this);
     // DBG() << pp::Event<VMI_EVENT_INTERRUPT, 0>(event) << std::endl;
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (vmi_register_event(vmi, event) == VMI_FAILURE) {
       delete reinterpret_cast<event::EventData<BreakpointRegistry>*>(
         event->data);
@@ -217,20 +222,75 @@ public:
       throw BreakpointEventNotRegisteredError();
     }
     DBG() << "BreakpointRegistry::unregisterEvent()" << std::endl;
-    vmi_clear_event(vmi, event, doAfterClearEvent);
+    {
+      std::lock_guard<VMILock> guard(VMILock::of(vmi));
+      vmi_clear_event(vmi, event, doAfterClearEvent);
+    }
     event = nullptr;  // Mark free-in-progress
   }
 
+  /**
+   * @brief Enable all registered breakpoints that are not yet enabled.
+   * 
+   * The original instructions are read with a single batch read and the
+   * breakpoint instructions are written as one `memory::PatchSet`, i.e., one
+   * translation and one write per page touched instead of per breakpoint.
+   * Either all the breakpoints are enabled or none is (a
+   * `memory::MemoryWriteError` is thrown). The guest must be paused.
+   * 
+   */
+  inline void enableAll() {
+    DBG() << "Breakpoint::enableAll()" << std::endl;
+    std::vector<Breakpoint *> toEnable;
+    std::vector<memory::ReadRequest> reads;
+    for (auto &it : bps) {
+      Breakpoint *bp = it.second.get();
+      if (bp->enabled) continue;
+      toEnable.push_back(bp);
+      reads.push_back(memory::ReadRequest{bp->addr, 15, bp->emul.data});
+    }
+    if (toEnable.empty()) return;
+    memory::readMany(vmi, reads);
+    memory::PatchSet patches(vmi);
+    for (Breakpoint *bp : toEnable) {
+      patches.add(bp->addr, breakpointInstruction);
+    }
+    patches.apply();
+    for (Breakpoint *bp : toEnable) bp->enabled = true;
+    DBG() << "  " << F_DEC(toEnable.size()) << " breakpoint(s) in "
+          << F_DEC(patches.getPages()) << " page(s)" << std::endl;
+  }
+
   /**
    * @brief Disable all registered breakpoints.
    * 
+   * The original instructions are restored as one `memory::PatchSet`. If that
+   * fails, the breakpoints are disabled one by one and the failures are
+   * collected in a `DisableAllError`.
+   * 
    */
   inline void disableAll() {
     DBG() << "Breakpoint::disableAll()" << std::endl;
+    std::vector<Breakpoint *> toDisable;
+    memory::PatchSet patches(vmi);
+    for (auto &it : bps) {
+      Breakpoint *bp = it.second.get();
+      if (!bp->enabled) continue;
+      toDisable.push_back(bp);
+      patches.add(bp->addr, bp->emul.data[0]);
+    }
+    if (toDisable.empty()) return;
+    try {
+      patches.apply();
+      for (Breakpoint *bp : toDisable) bp->enabled = false;
+      return;
+    } catch (memory::MemoryWriteError &) {
+      DBG() << "  falling back to disabling one by one" << std::endl;
+    }
     std::vector<memory::MemoryWriteError> errors;
-    for (auto it : bps) {
+    for (Breakpoint *bp : toDisable) {
       try {
-        it.second->disable();
+        bp->disable();
       } catch (memory::MemoryWriteError &err) {
         errors.push_back(err);
       }
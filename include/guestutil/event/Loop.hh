@@ -4,12 +4,14 @@
 
 #include <string>  // std::string
 #include <functional>  // std::function
+#include <mutex>  // std::lock_guard, std::unique_lock
 
 #include <libvmi/libvmi.h>
 #include <libvmi/events.h>
 
 #include <debug.hh>
 #include <guestutil/VM.hh>
+#include <guestutil/VMILock.hh>
 #include <guestutil/event/error.hh>
 
 
@@ -58,6 +60,10 @@ private:
     if (err) {
       throw BumpError();
     }
+    // The guest ran since the last callbacks, their translations are stale
+    memory::TLB::of(vm.getVMI()).flush();
+    // The callbacks run under the lock as well
+    std::lock_guard<VMILock> guard(VMILock::of(vm.getVMI()));
     if (vmi_events_listen(vm.getVMI(), 500) == VMI_FAILURE) {
       throwErr<ListenError>();
     }
@@ -74,6 +80,7 @@ private:
    */
   inline void handlePause() {
     vm.pause();
+    std::unique_lock<VMILock> guard(VMILock::of(vm.getVMI()));
     int nPending = vmi_are_events_pending(vm.getVMI());
     DBG() << "Loop::handlePause() - draining " << nPending << " event(s)"
           << std::endl;
@@ -95,6 +102,8 @@ private:
       // Someone requested stop when we are trying to pause the event loop
       throwErr<StoppingError>();
     }
+    // Not under the lock, so the callback may prefetch (see `Prefetcher`)
+    guard.unlock();
     DBG() << "Loop::handlePause() - calling onPauseCallback" << std::endl;
     try {
       onPausedCallback();  // May request stop
@@ -118,18 +127,29 @@ public:
    * @brief Bump the event loop until we have an error or received a stop
    * signal.
    * 
+   * The TLB (see `memory::TLB`) is flushed on entry, on exit and before
+   * every `vmi_events_listen`, as the guest runs in between.
+   * 
    * @return EventError* error occurred if any
    */
   inline EventError *bump() {
     DBG() << "Loop::bump()" << std::endl;
-    while (!err && stopRequestedBy.empty()) {
-      if (onPausedCallback) {
-        handlePause();
-        onPausedCallback = nullptr;
-      } else {
-        bumpOnce();
+    memory::TLB &tlb = memory::TLB::of(vm.getVMI());
+    tlb.flush();
+    try {
+      while (!err && stopRequestedBy.empty()) {
+        if (onPausedCallback) {
+          handlePause();
+          onPausedCallback = nullptr;
+        } else {
+          bumpOnce();
+        }
       }
+    } catch (...) {
+      tlb.flush();
+      throw;
     }
+    tlb.flush();
     return err;
   }
 
@@ -8,9 +8,11 @@
 #include <functional>  // std::function
 #include <vector>  // std::vector
 #include <exception>
+#include <mutex>  // std::lock_guard
 
 #include <guestutil/event/data.hh>
 #include <guestutil/event/error.hh>
+#include <guestutil/VMILock.hh>
 #include <EventEmitter.hh>
 #include <debug.hh>
 #include <pretty-print.hh>
@@ -323,6 +325,7 @@ private:
     DBG() << "MemEvent::register()" << std::endl
           << pp::Event<VMI_EVENT_MEMORY, 2>(memEvent) << std::endl;
     // Register the memory event itself
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (vmi_register_event(vmi, &memEvent) == VMI_FAILURE) {
       throw RegistrationError();
     }
@@ -339,6 +342,7 @@ private:
     // Make sure LibVMI is operating on the correct SLAT
     // Not sure if this is how it works
     memEvent.slat_id = trapSlat;
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (vmi_clear_event(vmi, &memEvent, onEventCleared) == VMI_FAILURE) {
       throw UnregistrationError();
     }
@@ -351,7 +355,11 @@ private:
    */
   inline status_t tryUnregister() {
     if (!registered) return VMI_FAILURE;
-    status_t res = vmi_clear_event(vmi, &memEvent, onEventCleared);
+    status_t res = VMI_FAILURE;
+    {
+      std::lock_guard<VMILock> guard(VMILock::of(vmi));
+      res = vmi_clear_event(vmi, &memEvent, onEventCleared);
+    }
     DBG() << "MemEvent::tryUnregister(): " <<
       (res == VMI_FAILURE ? "failed" : "successful") << std::endl;
     return res;
@@ -14,10 +14,12 @@ extern "C" {
 #include <map>  // std::map
 #include <memory>  // std::shared_ptr
 #include <exception>
+#include <mutex>  // std::lock_guard
 
 #include <guestutil/mem.hh>
 #include <guestutil/event/MemEvent.hh>
 #include <guestutil/event/singlestep.hh>
+#include <guestutil/VMILock.hh>
 #include <EventEmitter.hh>
 #include <debug.hh>
 
@@ -226,6 +228,7 @@ public:
 
   virtual ~MemEventRegistry() {
     DBG() << "~MemEventRegistry()" << std::endl;
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (xc) {
       if (xc_interface_close(xc) < 0) {
         DBG() << "  xc_interface_close failed, ignoring" << std::endl;
@@ -361,6 +364,7 @@ private:
       default: break;  // No need to change
     }
     // Set altp2m domain state
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     if (vmi_slat_set_domain_state(vmi, true) == VMI_FAILURE) {
       throw RegistryInitError(
         VMI_SLAT_SET_DOMAIN_STATE,
@@ -374,6 +378,7 @@ private:
    * 
    */
   inline void initSlat() {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
     // Create a new SLAT for trapping
     // Initially, the new SLAT has the same permission
     // with the default one I suppose?
@@ -16,8 +16,10 @@
 #include <libvmi/events.h>
 
 #include <exception>
+#include <mutex>  // std::lock_guard
 
 #include <guestutil/event/error.hh>
+#include <guestutil/VMILock.hh>
 
 
 namespace guestutil {
@@ -63,6 +65,7 @@ inline void registerCatchAllSinglestepEvent(
   for (unsigned int vCPU = 0; vCPU < nVCPUs; vCPU++) {
     SET_VCPU_SINGLESTEP(event.ss_event, vCPU);
   }
+  std::lock_guard<VMILock> guard(VMILock::of(vmi));
   if (vmi_register_event(vmi, &event) == VMI_FAILURE) {
     vmi_clear_event(vmi, &event, nullptr);
     throw RegistrationError();
@@ -12,8 +12,17 @@
 #define C7F49205_DA22_46A3_A0D9_8D4123F1D4AE
 
 #include <libvmi/libvmi.h>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/symbol/SymbolCache.hh>
+#include <guestutil/VMILock.hh>
 #include <exception>
+#include <mutex>  // std::lock_guard
 #include <string>
+#include <string_view>
+#include <algorithm>  // std::min
+#include <cstring>  // std::memchr
+#include <cstdlib>  // std::malloc, std::free
 
 namespace guestutil {
 namespace memory {
@@ -29,14 +38,17 @@ enum MemoryReadAccess {
   READ_32_KVA,
   READ_64_KVA,
   READ_ADDR_KVA,
-  READ_STR_KVA
+  READ_STR_KVA,
+  READ_MANY,
+  READ_DUMP
 };
 
 enum MemoryWriteAccess {
   WRITE_8_KVA,
   WRITE_16_KVA,
   WRITE_32_KVA,
-  WRITE_64_KVA
+  WRITE_64_KVA,
+  WRITE_PATCH_SET
 };
 
 #define UINT_N_T(size) uint ## size ## _t
@@ -98,6 +110,7 @@ inline size_t readVA(
   size_t count,
   void *buff
 ) {
+  std::lock_guard<VMILock> guard(VMILock::of(vmi));
   size_t bytesRead = 0;
   if (vmi_read_va(vmi, va, pid, count, buff, &bytesRead) == VMI_FAILURE) {
     throw MemoryReadError(va, READ_VA);
@@ -107,28 +120,76 @@ inline size_t readVA(
 
 /**
  * @brief Read `count` bytes into `buff` from memory located at kernel virtual
- * address `kva`.
+ * address `kva`, through the page cache of `vmi` if it is enabled. Same as
+ * `readKVA`, but return `VMI_FAILURE` instead of throwing.
  * 
  * @param[in] vmi 
  * @param[in] kva 
  * @param[in] count 
  * @param[out] buff 
+ * @return status_t 
  */
-inline void readKVA(
+inline status_t tryReadKVA(
   vmi_instance_t vmi,
   addr_t kva,
   size_t count,
   void *buff
 ) {
+  PageCache &cache = PageCache::of(vmi);
+  if (cache.isEnabled()) {
+    return cache.read(kva, count, buff);
+  }
+  std::lock_guard<VMILock> guard(VMILock::of(vmi));
   size_t bytesRead = 0;
   if (
     vmi_read_va(vmi, kva, 0, count, buff, &bytesRead) == VMI_FAILURE ||
     bytesRead != count  // Magic?
   ) {
+    return VMI_FAILURE;
+  }
+  return VMI_SUCCESS;
+}
+
+/**
+ * @brief Read `count` bytes into `buff` from memory located at kernel virtual
+ * address `kva`.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva 
+ * @param[in] count 
+ * @param[out] buff 
+ */
+inline void readKVA(
+  vmi_instance_t vmi,
+  addr_t kva,
+  size_t count,
+  void *buff
+) {
+  if (tryReadKVA(vmi, kva, count, buff) == VMI_FAILURE) {
     throw MemoryReadError(kva, READ_KVA);
   }
 }
 
+/**
+ * @brief Read an address (pointer) from kernel virtual address (KVA). Same as
+ * `readAddrKVA`, but return `VMI_FAILURE` instead of throwing.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva kernel virtual address of the address (pointer) to be read.
+ * @param[out] addr 
+ * @return status_t 
+ */
+inline status_t tryReadAddrKVA(vmi_instance_t vmi, addr_t kva, addr_t &addr) {
+  addr = 0;
+  PageCache &cache = PageCache::of(vmi);
+  if (cache.isEnabled()) {
+    // Little-endian, so reading the lower 4 bytes is fine on 32-bit guests
+    return cache.read(kva, vmi_get_address_width(vmi), &addr);
+  }
+  std::lock_guard<VMILock> guard(VMILock::of(vmi));
+  return vmi_read_addr_va(vmi, kva, 0, &addr);
+}
+
 /**
  * @brief Read an address (pointer) from kernel virtual address (KVA).
  * 
@@ -140,7 +201,7 @@ inline void readKVA(
 template <typename _ = addr_t>
 inline addr_t readAddrKVA(vmi_instance_t vmi, addr_t kva) {
   addr_t res = 0;
-  if (vmi_read_addr_va(vmi, kva, 0, &res) == VMI_FAILURE) {
+  if (tryReadAddrKVA(vmi, kva, res) == VMI_FAILURE) {
     throw MemoryReadError(kva, READ_ADDR_KVA);
   }
   return res;
@@ -158,7 +219,15 @@ inline addr_t readAddrKVA(vmi_instance_t vmi, addr_t kva) {
   template <typename I_N(size) = UINT_N_T(size)> \
   inline I_N(size) READ_X_KVA_FN_NAME(size)(vmi_instance_t vmi, addr_t kva) { \
     UINT_N_T(size) res = 0; \
-    if (VMI_READ_X_VA(size)(vmi, kva, 0, &res) == VMI_FAILURE) { \
+    PageCache &cache = PageCache::of(vmi); \
+    status_t status = VMI_FAILURE; \
+    if (cache.isEnabled()) { \
+      status = cache.read(kva, sizeof(res), &res); \
+    } else { \
+      std::lock_guard<VMILock> guard(VMILock::of(vmi)); \
+      status = VMI_READ_X_VA(size)(vmi, kva, 0, &res); \
+    } \
+    if (status == VMI_FAILURE) { \
       throw MemoryReadError(kva, READ_X_KVA_ACC_NAME(size)); \
     } \
     return *reinterpret_cast<I_N(size) *>(&res); \
@@ -203,6 +272,32 @@ DEFINE_READ_UINT_N_KVA_ALIAS(64);
  */
 inline char *readStrKVA(vmi_instance_t vmi, addr_t kva) {
   char *res;
+  PageCache &cache = PageCache::of(vmi);
+  if (cache.isEnabled()) {
+    // Find the terminating NUL page by page, then copy the whole string
+    size_t len = 0;
+    for (addr_t pos = kva;;) {
+      const uint8_t *page = cache.getPage(pos);
+      if (!page) throw MemoryReadError(kva, READ_STR_KVA);
+      addr_t offset = pos & PageCache::pageMask;
+      size_t n = PageCache::pageSize - offset;
+      const void *nul = std::memchr(page + offset, 0, n);
+      if (nul) {
+        len += reinterpret_cast<const uint8_t *>(nul) - (page + offset);
+        break;
+      }
+      len += n;
+      pos += n;
+    }
+    // Allocated the same way as LibVMI does
+    res = reinterpret_cast<char *>(std::malloc(len + 1));
+    if (!res || cache.read(kva, len + 1, res) == VMI_FAILURE) {
+      std::free(res);
+      throw MemoryReadError(kva, READ_STR_KVA);
+    }
+    return res;
+  }
+  std::lock_guard<VMILock> guard(VMILock::of(vmi));
   if (!(res = vmi_read_str_va(vmi, kva, 0))) {
     throw MemoryReadError(kva, READ_STR_KVA);
   }
@@ -212,10 +307,70 @@ inline char *readStrKVA(vmi_instance_t vmi, addr_t kva) {
 inline std::string readCppStrKVA(vmi_instance_t vmi, addr_t kva) {
   char *cStr = readStrKVA(vmi, kva);
   std::string cppStr(cStr);
-  delete []cStr;
+  std::free(cStr);  // Allocated by `malloc`
   return cppStr;
 }
 
+/**
+ * @brief Read a string of at most `size` bytes from kernel virtual address
+ * (KVA) into the caller-supplied `buff`, stopping at the first NUL. No heap
+ * allocation is involved, and short strings take a single read (two if the
+ * string crosses a page boundary, so that an unmapped page after the string
+ * does not fail the read).
+ * 
+ * Note that `buff` is not NUL-terminated if the string fills it up.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva kernel virtual address of the string to be read.
+ * @param[out] buff 
+ * @param[in] size size of `buff`.
+ * @return size_t length of the string read (excluding the NUL).
+ */
+inline size_t readStrKVA(
+  vmi_instance_t vmi,
+  addr_t kva,
+  char *buff,
+  size_t size
+) {
+  size_t len = 0;
+  while (len < size) {
+    addr_t pos = kva + len;
+    size_t n = std::min<size_t>(
+      size - len, PageCache::pageSize - (pos & PageCache::pageMask));
+    if (tryReadKVA(vmi, pos, n, buff + len) == VMI_FAILURE) {
+      throw MemoryReadError(kva, READ_STR_KVA);
+    }
+    const void *nul = std::memchr(buff + len, 0, n);
+    if (nul) return reinterpret_cast<const char *>(nul) - buff;
+    len += n;
+  }
+  return len;
+}
+
+/**
+ * @brief Read a string of at most `N` bytes from kernel virtual address (KVA)
+ * into the array `buff`. E.g., for `task_struct.comm`:
+ * 
+ * ```C++
+ * char comm[16];  // TASK_COMM_LEN
+ * std::string_view name = memory::readStrKVA(vmi, task + nameOffset, comm);
+ * ```
+ * 
+ * @tparam N size of `buff`.
+ * @param[in] vmi 
+ * @param[in] kva kernel virtual address of the string to be read.
+ * @param[out] buff 
+ * @return std::string_view view of the string in `buff`.
+ */
+template <size_t N>
+inline std::string_view readStrKVA(
+  vmi_instance_t vmi,
+  addr_t kva,
+  char (&buff)[N]
+) {
+  return std::string_view(buff, readStrKVA(vmi, kva, buff, N));
+}
+
 /* ======== Write ======== */
 
 #define WRITE_X_KVA_FN_NAME(x) write ## x ## KVA
@@ -229,9 +384,12 @@ inline std::string readCppStrKVA(vmi_instance_t vmi, addr_t kva) {
 #define DEFINE_WRITE_N_KVA(size) \
   template <typename I_N(size) = UINT_N_T(size)> \
   inline void WRITE_X_KVA_FN_NAME(size)(vmi_instance_t vmi, addr_t kva, I_N(size) &val) { \
+    std::lock_guard<VMILock> guard(VMILock::of(vmi)); \
     if (VMI_WRITE_X_VA(size)(vmi, kva, 0, &val) == VMI_FAILURE) { \
+      PageCache::of(vmi).invalidate(kva, sizeof(val)); \
       throw MemoryWriteError(kva, WRITE_X_KVA_ACC_NAME(size)); \
     } \
+    PageCache::of(vmi).update(kva, sizeof(val), &val); \
   } \
   template <typename I_N(size) = UINT_N_T(size)> \
   class WRITE_X_KVA_CLS_NAME(size) { \
@@ -301,6 +459,11 @@ enum TranslationType {
    * 
    */
   KSYM_TO_GFN,
+  /**
+   * @brief Guest frame number to kernel virtual address (reverse mapping).
+   * 
+   */
+  GFN_TO_KVA,
 };
 
 /* ======== Errors ======== */
@@ -339,13 +502,38 @@ public:
  * @brief The number of lower bits to discard when calculating the frame
  * number.
  * 
- * For now, this is hardcoded as 12 (x86 specific).
+ * For now, this is hardcoded as 12 (x86 specific). GFNs and page numbers are
+ * always in units of 4 KiB, even if the page is part of a huge mapping (see
+ * `HUGE_PAGE_SHIFT` and `GIANT_PAGE_SHIFT`).
  * 
  * @see https://www.kernel.org/doc/Documentation/virtual/kvm/mmu.txt
  * 
  */
 constexpr unsigned int PAGE_SHIFT = 12;
 
+/**
+ * @brief The number of lower bits of a 2 MiB mapping (x86-64 specific).
+ * 
+ */
+constexpr unsigned int HUGE_PAGE_SHIFT = 21;
+
+/**
+ * @brief The number of lower bits of a 1 GiB mapping (x86-64 specific).
+ * 
+ */
+constexpr unsigned int GIANT_PAGE_SHIFT = 30;
+
+/**
+ * @brief Get the number of lower bits of a mapping of `size` bytes.
+ * 
+ * @param size 4 KiB, 2 MiB or 1 GiB.
+ * @return unsigned int
+ */
+inline unsigned int mappingShift(addr_t size) {
+  return size >= (addr_t(1) << GIANT_PAGE_SHIFT) ? GIANT_PAGE_SHIFT :
+    size >= (addr_t(1) << HUGE_PAGE_SHIFT) ? HUGE_PAGE_SHIFT : PAGE_SHIFT;
+}
+
 /**
  * @brief Convert a GPA (Guest Physical Address) to GFN (Guest Frame Number).
  * 
@@ -367,6 +555,42 @@ inline addr_t glaToPageNum(addr_t gla) {
   return gla >> PAGE_SHIFT;
 }
 
+/**
+ * @brief Convert a KVA (Kernel Virtual Address) to GPA (Guest Physical
+ * Address) through the software TLB of `vmi`. Same as `kvaToGPA`, but return
+ * `VMI_FAILURE` instead of throwing.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva The guest kernel virtual address to be translated.
+ * @param[out] gpa The guest physical address of given guest kernel virtual
+ * address.
+ * @return status_t 
+ */
+inline status_t tryKvaToGPA(vmi_instance_t vmi, addr_t kva, addr_t &gpa) {
+  return TLB::of(vmi).translateKernel(kva, gpa);
+}
+
+/**
+ * @brief Same as `tryKvaToGPA`, but also report the size of the mapping
+ * containing `kva` (4 KiB, 2 MiB or 1 GiB), so that callers iterating over
+ * a huge mapping can skip to its end.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva The guest kernel virtual address to be translated.
+ * @param[out] gpa The guest physical address of given guest kernel virtual
+ * address.
+ * @param[out] size The size of the mapping containing `kva`.
+ * @return status_t 
+ */
+inline status_t tryKvaToGPA(
+  vmi_instance_t vmi,
+  addr_t kva,
+  addr_t &gpa,
+  addr_t &size
+) {
+  return TLB::of(vmi).translateKernel(kva, gpa, size);
+}
+
 /**
  * @brief Convert a KVA (Kernel Virtual Address) to GPA (Guest Physical
  * Address).
@@ -378,12 +602,28 @@ inline addr_t glaToPageNum(addr_t gla) {
  */
 inline addr_t kvaToGPA(vmi_instance_t vmi, addr_t kva) {
   addr_t gpa = 0;
-  if (vmi_translate_kv2p(vmi, kva, &gpa) == VMI_FAILURE) {
+  if (tryKvaToGPA(vmi, kva, gpa) == VMI_FAILURE) {
     throw MemoryTranslationError(KVA_TO_GPA, kva, nullptr);
   }
   return gpa;
 }
 
+/**
+ * @brief Convert a KVA (Kernel Virtual Address) to GFN (Guest Frame Number).
+ * Same as `kvaToGFN`, but return `VMI_FAILURE` instead of throwing.
+ * 
+ * @param[in] vmi 
+ * @param[in] kva The guest kernel virtual address to be translated.
+ * @param[out] gfn The frame number of given guest kernel virtual address.
+ * @return status_t 
+ */
+inline status_t tryKvaToGFN(vmi_instance_t vmi, addr_t kva, addr_t &gfn) {
+  addr_t gpa = 0;
+  if (tryKvaToGPA(vmi, kva, gpa) == VMI_FAILURE) return VMI_FAILURE;
+  gfn = gpaToGFN(gpa);
+  return VMI_SUCCESS;
+}
+
 /**
  * @brief Convert a KVA (Kernel Virtual Address) to GFN (Guest Frame Number).
  * 
@@ -392,8 +632,11 @@ inline addr_t kvaToGPA(vmi_instance_t vmi, addr_t kva) {
  * @return addr_t The frame number of given guest kernel virtual address.
  */
 inline addr_t kvaToGFN(vmi_instance_t vmi, addr_t kva) {
-  // Translate to GPA first, and then to GFN
-  return gpaToGFN(kvaToGPA(vmi, kva));
+  addr_t gfn = 0;
+  if (tryKvaToGFN(vmi, kva, gfn) == VMI_FAILURE) {
+    throw MemoryTranslationError(KVA_TO_GFN, kva, nullptr);
+  }
+  return gfn;
 }
 
 /**
@@ -405,7 +648,8 @@ inline addr_t kvaToGFN(vmi_instance_t vmi, addr_t kva) {
  */
 inline addr_t ksymToKVA(vmi_instance_t vmi, const char *symbol) {
   addr_t kva = 0;
-  if (vmi_translate_ksym2v(vmi, symbol, &kva) == VMI_FAILURE) {
+  // Cached per VMI, see `symbol::SymbolCache`
+  if (symbol::SymbolCache::of(vmi).tryTranslate(symbol, kva) == VMI_FAILURE) {
     throw MemoryTranslationError(KSYM_TO_KVA, 0, symbol);
   }
   return kva;
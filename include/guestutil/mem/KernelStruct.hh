@@ -0,0 +1,269 @@
+/**
+ * @file KernelStruct.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Compile-time descriptors of guest kernel structs.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A9D3F6C1_4B82_4E07_B5A9_8E1C2F7D6B39
+#define A9D3F6C1_4B82_4E07_B5A9_8E1C2F7D6B39
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/batch.hh>
+#include <guestutil/mem/StructSnapshot.hh>
+#include <guestutil/offset/OffsetTable.hh>
+
+#include <array>  // std::array
+#include <vector>  // std::vector
+#include <string_view>  // std::string_view
+#include <type_traits>  // std::integral_constant, std::is_trivially_copyable
+#include <cstring>  // std::memcpy, std::memchr
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Descriptor of a field of trivially copyable type `T`, whose offset
+ * is `offset::OffsetTable` entry `K`.
+ * 
+ * Declare fields as distinct types, e.g.,
+ * `struct pid: memory::Field<vmi_pid_t, offset::LINUX_PID> {};`.
+ * 
+ * @tparam T
+ * @tparam K
+ */
+template <typename T, offset::OffsetKey K>
+struct Field {
+  static_assert(std::is_trivially_copyable<T>::value,
+    "Field type must be trivially copyable");
+  using Type = T;
+  static constexpr offset::OffsetKey key = K;
+  static constexpr size_t size = sizeof(T);
+
+  static inline T extract(const uint8_t *ptr) {
+    T val;
+    std::memcpy(&val, ptr, sizeof(T));
+    return val;
+  }
+};
+
+/**
+ * @brief Descriptor of a `char[N]` field holding a (NUL-terminated, at most
+ * `N` bytes) string, whose offset is `offset::OffsetTable` entry `K`.
+ * 
+ * @tparam N
+ * @tparam K
+ */
+template <size_t N, offset::OffsetKey K>
+struct StrField {
+  using Type = std::string_view;
+  static constexpr offset::OffsetKey key = K;
+  static constexpr size_t size = N;
+
+  static inline std::string_view extract(const uint8_t *ptr) {
+    const char *str = reinterpret_cast<const char *>(ptr);
+    const void *nul = std::memchr(str, 0, N);
+    return std::string_view(
+      str, nul ? reinterpret_cast<const char *>(nul) - str : N);
+  }
+};
+
+
+namespace detail {
+
+
+/**
+ * @brief Index of `F` in `Fs...` (fails to compile if absent).
+ * 
+ */
+template <typename F, typename... Fs>
+struct FieldIndex;
+
+template <typename F, typename... Rest>
+struct FieldIndex<F, F, Rest...>: std::integral_constant<size_t, 0> {};
+
+template <typename F, typename G, typename... Rest>
+struct FieldIndex<F, G, Rest...>:
+  std::integral_constant<size_t, 1 + FieldIndex<F, Rest...>::value> {};
+
+
+}
+
+/**
+ * @brief Layout of a guest kernel struct, described by the field types
+ * `Fields...` (see `Field` and `StrField`), with the offsets resolved at
+ * runtime (normally from `offset::OffsetTable::of(vmi)`, i.e., when the VM
+ * is attached).
+ * 
+ * Field types and sizes are fixed at compile time, so extracting a field is
+ * a single fixed-size copy from a precomputed position, and the reads of all
+ * the declared fields are batched automatically (see `Snapshot`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * struct pid: memory::Field<vmi_pid_t, offset::LINUX_PID> {};
+ * struct comm: memory::StrField<16, offset::LINUX_NAME> {};
+ * using Task = memory::KernelStruct<pid, comm>;
+ * 
+ * Task taskStruct = Task::of(vmi);
+ * Task::Snapshot task(taskStruct);
+ * task.read(vmi, taskAddr);
+ * std::cout << task.get<comm>() << ' ' << task.get<pid>() << std::endl;
+ * ```
+ * 
+ * @tparam Fields
+ */
+template <typename... Fields>
+class KernelStruct {
+public:
+  static constexpr size_t nFields = sizeof...(Fields);
+  static_assert(nFields > 0, "KernelStruct needs at least one field");
+
+  /**
+   * @brief Index of field `F` (at compile time).
+   * 
+   * @tparam F
+   */
+  template <typename F>
+  static constexpr size_t indexOf = detail::FieldIndex<F, Fields...>::value;
+
+  /**
+   * @brief Snapshot of an object of this struct, holding the bytes of all the
+   * declared fields.
+   * 
+   */
+  class Snapshot: public StructSnapshot {
+  private:
+    /**
+     * @brief Position of each field in the snapshot data.
+     * 
+     */
+    std::array<addr_t, nFields> positions;
+    std::array<addr_t, nFields> offsets;
+  public:
+    Snapshot(const KernelStruct &desc):
+      StructSnapshot(desc.getLayout()), positions(), offsets(desc.offsets) {
+      for (size_t i = 0; i < nFields; i++) {
+        positions[i] = offsets[i] - layout.getBegin();
+      }
+    };
+
+    /**
+     * @brief Read the fields of the object at kernel virtual address
+     * `objAddr` with a batch read of the fields only (see `readMany`), instead
+     * of the whole span as `read` does. Better when the fields are far apart.
+     * 
+     * @param vmi
+     * @param objAddr
+     * @return Snapshot& this snapshot.
+     */
+    inline Snapshot &readFields(vmi_instance_t vmi, addr_t objAddr) {
+      constexpr size_t sizes[nFields] = {Fields::size...};
+      std::vector<ReadRequest> requests;
+      requests.reserve(nFields);
+      for (size_t i = 0; i < nFields; i++) {
+        requests.push_back(ReadRequest{
+          objAddr + offsets[i], sizes[i], data.data() + positions[i]
+        });
+      }
+      readMany(vmi, requests);
+      addr = objAddr;
+      return *this;
+    }
+
+    /**
+     * @brief Extract field `F`.
+     * 
+     * @tparam F
+     * @return F::Type (a `std::string_view` valid until the next read for a
+     * `StrField`).
+     */
+    template <typename F>
+    inline typename F::Type get() const {
+      return F::extract(data.data() + positions[indexOf<F>]);
+    }
+  };
+private:
+  std::array<addr_t, nFields> offsets;
+  StructLayout layout;
+public:
+  KernelStruct(): offsets(), layout() {};
+
+  /**
+   * @brief Describe the struct with explicit offsets.
+   * 
+   * @param _offsets offsets of `Fields...`, in order.
+   */
+  KernelStruct(const std::array<addr_t, nFields> &_offsets):
+    offsets(_offsets), layout() {
+    constexpr size_t sizes[nFields] = {Fields::size...};
+    for (size_t i = 0; i < nFields; i++) layout.add(offsets[i], sizes[i]);
+  };
+
+  /**
+   * @brief Describe the struct with the offsets of `table`.
+   * 
+   * @param table
+   * @return KernelStruct
+   */
+  static KernelStruct fromTable(const offset::OffsetTable &table) {
+    return KernelStruct({table.get(Fields::key)...});
+  }
+
+  /**
+   * @brief Describe the struct with the offsets resolved for `vmi`.
+   * 
+   * @param vmi
+   * @return KernelStruct
+   */
+  static KernelStruct of(vmi_instance_t vmi) {
+    return fromTable(offset::OffsetTable::of(vmi));
+  }
+
+  template <typename F>
+  inline addr_t offsetOf() const {
+    return offsets[indexOf<F>];
+  }
+
+  /**
+   * @brief Get the layout covering all the fields.
+   * 
+   * @return const StructLayout&
+   */
+  inline const StructLayout &getLayout() const {
+    return layout;
+  }
+
+  /**
+   * @brief Read field `F` of the object at `objAddr` alone.
+   * 
+   * @tparam F a `Field` (not a `StrField`).
+   * @param vmi
+   * @param objAddr
+   * @return F::Type
+   */
+  template <typename F>
+  inline typename F::Type read(vmi_instance_t vmi, addr_t objAddr) const {
+    static_assert(!std::is_same<typename F::Type, std::string_view>::value,
+      "Read string fields with a Snapshot");
+    uint8_t buff[F::size];
+    readKVA(vmi, objAddr + offsetOf<F>(), F::size, buff);
+    return F::extract(buff);
+  }
+};
+
+
+}
+}
+
+
+#endif /* A9D3F6C1_4B82_4E07_B5A9_8E1C2F7D6B39 */
@@ -0,0 +1,394 @@
+/**
+ * @file PageCache.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Page-granular cache of guest kernel memory, invalidated by epochs.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef E2A8B7C4_5F1D_4C39_9E0A_3B6D1F7C2A94
+#define E2A8B7C4_5F1D_4C39_9E0A_3B6D1F7C2A94
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <memory>  // std::unique_ptr
+#include <functional>  // std::function
+#include <cstring>  // std::memcpy
+#include <algorithm>  // std::min
+#include <mutex>  // std::lock_guard
+#include <cstdint>
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Per `vmi_instance_t` page-granular cache of guest kernel memory.
+ * 
+ * Each cached page is tagged with the epoch in which it was read. Bumping the
+ * epoch invalidates every cached page at once without freeing the buffers,
+ * which are refilled in place on the next access.
+ * 
+ * The cache is disabled by default, and is only safe to use while the guest
+ * is paused. `vm::VM::pause()` enables it and `vm::VM::resume()` (or
+ * `tryResume()`) disables it, bumping the epoch either way. Our own writes
+ * through the `write*KVA` helpers are written through to cached pages.
+ * 
+ * Usage:
+ * 
+ * ```C++
+ * vm.pause();  // Cache enabled, new epoch
+ * procList.forEach(vmi, ...);  // Each page is read from the guest once
+ * vm.resume();  // Cache disabled, everything cached so far is stale
+ * ```
+ * 
+ */
+class PageCache {
+public:
+  /**
+   * @brief Same as `memory::PAGE_SHIFT` (x86 specific).
+   * 
+   */
+  static constexpr unsigned int pageShift = 12;
+  static constexpr addr_t pageSize = addr_t(1) << pageShift;
+  static constexpr addr_t pageMask = pageSize - 1;
+
+  /**
+   * @brief Cache statistics.
+   * 
+   */
+  struct Stats {
+    /**
+     * @brief Page lookups served from the cache.
+     * 
+     */
+    uint64_t hits;
+    /**
+     * @brief Page lookups that had to read from the guest.
+     * 
+     */
+    uint64_t misses;
+    /**
+     * @brief Page reads from the guest that failed.
+     * 
+     */
+    uint64_t failures;
+  };
+
+  /**
+   * @brief Fills the page of `pageNum` (kernel virtual page number) into
+   * `page` (`pageSize` bytes) on a miss, see `setMissHandler`.
+   * 
+   */
+  using MissHandler = std::function<status_t(addr_t pageNum, uint8_t *page)>;
+  /**
+   * @brief Called by `disable` before the guest resumes, see
+   * `setDisableHandler`.
+   * 
+   */
+  using DisableHandler = std::function<void()>;
+private:
+  struct Page {
+    /**
+     * @brief The epoch in which `data` was read, 0 if invalid.
+     * 
+     */
+    uint64_t epoch;
+    std::unique_ptr<uint8_t[]> data;
+  };
+
+  vmi_instance_t vmi;
+  /**
+   * @brief Cached pages keyed by (kernel virtual) page number.
+   * 
+   */
+  std::unordered_map<addr_t, Page> pages;
+  uint64_t epoch;
+  bool enabled;
+  /**
+   * @brief Maximum number of page buffers to keep.
+   * 
+   */
+  size_t capacity;
+  Stats stats;
+  MissHandler missHandler;
+  DisableHandler disableHandler;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<PageCache>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` caches.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<PageCache>> caches;
+    return caches;
+  }
+
+  /**
+   * @brief Make room for a new page buffer by dropping stale pages, or
+   * everything if there is no stale page.
+   * 
+   */
+  inline void evict() {
+    for (auto it = pages.begin(); it != pages.end();) {
+      if (it->second.epoch != epoch) it = pages.erase(it);
+      else it++;
+    }
+    if (pages.size() >= capacity) pages.clear();
+  }
+
+  PageCache(vmi_instance_t _vmi):
+    vmi(_vmi), pages(), epoch(1), enabled(false), capacity(1 << 16),
+    stats{0, 0, 0}, missHandler(), disableHandler() {};
+
+  PageCache(PageCache&) = delete;
+  PageCache(PageCache&&) = delete;
+public:
+  /**
+   * @brief Get the cache of `vmi` (created on first use).
+   * 
+   * @param vmi
+   * @return PageCache&
+   */
+  static PageCache &of(vmi_instance_t vmi) {
+    auto &caches = registry();
+    auto it = caches.find(vmi);
+    if (it == caches.end()) {
+      it = caches.emplace(vmi, std::unique_ptr<PageCache>(new PageCache(vmi)))
+        .first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the cache of `vmi` (if any). Called before `vmi` is destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  inline bool isEnabled() const {
+    return enabled;
+  }
+
+  inline uint64_t getEpoch() const {
+    return epoch;
+  }
+
+  /**
+   * @brief Invalidate everything cached so far by starting a new epoch.
+   * 
+   */
+  inline void invalidate() {
+    epoch++;
+    DBG() << "PageCache.invalidate() - epoch " << F_DEC(epoch) << std::endl;
+  }
+
+  /**
+   * @brief Invalidate the cached pages touched by `[kva, kva + count)`.
+   * 
+   * @param kva
+   * @param count
+   */
+  inline void invalidate(addr_t kva, size_t count) {
+    if (!count) return;
+    addr_t endPage = (kva + count - 1) >> pageShift;
+    for (addr_t pageNum = kva >> pageShift; pageNum <= endPage; pageNum++) {
+      auto it = pages.find(pageNum);
+      if (it != pages.end()) it->second.epoch = 0;
+    }
+  }
+
+  /**
+   * @brief Enable the cache (the guest must be paused) and start a new epoch.
+   * 
+   */
+  inline void enable() {
+    invalidate();
+    enabled = true;
+  }
+
+  /**
+   * @brief Disable the cache (e.g., the guest is about to resume) and start a
+   * new epoch. The disable handler (if any) is called first.
+   * 
+   */
+  inline void disable() {
+    if (disableHandler) disableHandler();
+    invalidate();
+    enabled = false;
+  }
+
+  /**
+   * @brief Set the maximum number of cached pages.
+   * 
+   * @param pages
+   */
+  inline void setCapacity(size_t pages) {
+    capacity = pages ? pages : 1;
+  }
+
+  inline Stats getStats() const {
+    return stats;
+  }
+
+  inline void resetStats() {
+    stats = {0, 0, 0};
+  }
+
+  /**
+   * @brief Read missed pages with `handler` instead of from the guest
+   * directly (e.g., to serve prefetched pages, see `Prefetcher`). Pass an
+   * empty handler to restore the default.
+   * 
+   * @param handler
+   */
+  inline void setMissHandler(MissHandler handler) {
+    missHandler = std::move(handler);
+  }
+
+  /**
+   * @brief Call `handler` whenever the cache is disabled, before anything
+   * else (e.g., to stop the LibVMI calls of other threads before the guest
+   * resumes, see `Prefetcher`). Pass an empty handler to remove it.
+   * 
+   * @param handler
+   */
+  inline void setDisableHandler(DisableHandler handler) {
+    disableHandler = std::move(handler);
+  }
+
+  /**
+   * @brief If the page containing `kva` is cached in the current epoch.
+   * 
+   * @param kva
+   * @return bool
+   */
+  inline bool isCached(addr_t kva) const {
+    auto it = pages.find(kva >> pageShift);
+    return it != pages.end() && it->second.epoch == epoch;
+  }
+
+  /**
+   * @brief Read the page of `pageNum` (kernel virtual page number) from the
+   * guest into `page` (`pageSize` bytes), bypassing the cache.
+   * 
+   * @param pageNum
+   * @param page
+   * @return status_t
+   */
+  inline status_t fetch(addr_t pageNum, uint8_t *page) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    addr_t gpa = 0;
+    size_t bytesRead = 0;
+    if (
+      TLB::of(vmi).translateKernel(pageNum << pageShift, gpa) == VMI_FAILURE ||
+      vmi_read_pa(vmi, gpa, pageSize, page, &bytesRead) == VMI_FAILURE ||
+      bytesRead != pageSize
+    ) {
+      return VMI_FAILURE;
+    }
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Get the cached content of the page containing `kva`, reading it
+   * from the guest if it is not cached in the current epoch.
+   * 
+   * @param kva
+   * @return const uint8_t* the page content (`pageSize` bytes), or `nullptr`
+   * if the page cannot be read.
+   */
+  inline const uint8_t *getPage(addr_t kva) {
+    addr_t pageNum = kva >> pageShift;
+    auto it = pages.find(pageNum);
+    if (it != pages.end() && it->second.epoch == epoch) {
+      stats.hits++;
+      return it->second.data.get();
+    }
+    stats.misses++;
+    if (it == pages.end()) {
+      if (pages.size() >= capacity) evict();
+      it = pages.emplace(
+        pageNum, Page{0, std::unique_ptr<uint8_t[]>(new uint8_t[pageSize])}
+      ).first;
+    }
+    Page &page = it->second;
+    if (
+      (missHandler ? missHandler(pageNum, page.data.get()) :
+        fetch(pageNum, page.data.get())) == VMI_FAILURE
+    ) {
+      stats.failures++;
+      page.epoch = 0;
+      return nullptr;
+    }
+    page.epoch = epoch;
+    return page.data.get();
+  }
+
+  /**
+   * @brief Read `count` bytes into `buff` from kernel virtual address `kva`
+   * through the cache.
+   * 
+   * @param[in] kva
+   * @param[in] count
+   * @param[out] buff
+   * @return status_t `VMI_FAILURE` if any page touched cannot be read.
+   */
+  inline status_t read(addr_t kva, size_t count, void *buff) {
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buff);
+    while (count) {
+      const uint8_t *page = getPage(kva);
+      if (!page) return VMI_FAILURE;
+      addr_t offset = kva & pageMask;
+      size_t n = std::min<size_t>(count, pageSize - offset);
+      std::memcpy(dst, page + offset, n);
+      kva += n;
+      dst += n;
+      count -= n;
+    }
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Write `count` bytes from `buff` through to the cached pages touched
+   * by `[kva, kva + count)`, if any. Call this after the guest memory has been
+   * successfully written.
+   * 
+   * @param kva
+   * @param count
+   * @param buff
+   */
+  inline void update(addr_t kva, size_t count, const void *buff) {
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(buff);
+    while (count) {
+      addr_t offset = kva & pageMask;
+      size_t n = std::min<size_t>(count, pageSize - offset);
+      auto it = pages.find(kva >> pageShift);
+      if (it != pages.end() && it->second.epoch == epoch) {
+        std::memcpy(it->second.data.get() + offset, src, n);
+      }
+      kva += n;
+      src += n;
+      count -= n;
+    }
+  }
+};
+
+
+}
+}
+
+
+#endif /* E2A8B7C4_5F1D_4C39_9E0A_3B6D1F7C2A94 */
@@ -0,0 +1,337 @@
+/**
+ * @file PageHash.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Per-page hash snapshots of guest memory for change detection.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef E5B07A2C_94D1_4F3E_8C66_1A2F9D7B3E08
+#define E5B07A2C_94D1_4F3E_8C66_1A2F9D7B3E08
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/layout.hh>
+#include <guestutil/mem/ParallelScanner.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <algorithm>  // std::lower_bound
+#include <cstring>  // std::memcpy
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define GUESTUTIL_PAGE_HASH_X86 1
+#endif
+
+
+namespace guestutil {
+namespace memory {
+
+
+namespace pagehash {
+
+
+constexpr size_t pageSize = PageCache::pageSize;
+constexpr size_t nLanes = 8;
+constexpr size_t stripeSize = nLanes * sizeof(uint64_t);
+/**
+ * @brief Stripes between two scrambles of the accumulators (1 KiB).
+ * 
+ */
+constexpr size_t blockStripes = 16;
+constexpr uint64_t prime32 = 0x9e3779b1ull;
+constexpr uint64_t prime64_1 = 0x9e3779b185ebca87ull;
+constexpr uint64_t prime64_2 = 0x165667919e3779f9ull;
+constexpr uint64_t keys[nLanes] = {
+  0xbe4ba423396cfeb8ull, 0x1cad21f72c81017cull,
+  0xdb979083e96dd4deull, 0x1f67b3b7a4a44072ull,
+  0x78e5c0cc4ee679cbull, 0x2172ffcc7dd05a82ull,
+  0x8e2443f7744608b8ull, 0x4c263a81e69035e0ull
+};
+
+inline uint64_t mulFold(uint64_t a, uint64_t b) {
+  __uint128_t product = __uint128_t(a) * b;
+  return uint64_t(product) ^ uint64_t(product >> 64);
+}
+
+/**
+ * @brief The hash kernel, written as independent lanes with 32x32->64
+ * multiplies only, so that it is vectorized by the compiler (and inlined
+ * into the target specific versions below).
+ * 
+ */
+__attribute__((always_inline))
+inline uint64_t hashPageImpl(const uint8_t *page) {
+  uint64_t acc[nLanes];
+  for (size_t i = 0; i < nLanes; i++) acc[i] = keys[i];
+  constexpr size_t nStripes = pageSize / stripeSize;
+  for (size_t block = 0; block < nStripes; block += blockStripes) {
+    for (size_t s = block; s < block + blockStripes; s++) {
+      uint64_t words[nLanes];
+      std::memcpy(words, page + s * stripeSize, stripeSize);
+      for (size_t i = 0; i < nLanes; i++) {
+        uint64_t dk = words[i] ^ (keys[i] + s * prime64_2);
+        acc[i] += words[i] + (dk & 0xffffffffull) * (dk >> 32);
+      }
+    }
+    for (size_t i = 0; i < nLanes; i++) {
+      acc[i] = (acc[i] ^ (acc[i] >> 47) ^ keys[i]) * prime32;
+    }
+  }
+  uint64_t h = pageSize * prime64_1;
+  for (size_t i = 0; i < nLanes; i += 2) {
+    h += mulFold(acc[i] ^ keys[i], acc[i + 1] ^ keys[i + 1]);
+  }
+  h ^= h >> 37;
+  h *= prime64_2;
+  h ^= h >> 32;
+  return h;
+}
+
+#ifdef GUESTUTIL_PAGE_HASH_X86
+__attribute__((target("avx2")))
+inline uint64_t hashPageAVX2(const uint8_t *page) {
+  return hashPageImpl(page);
+}
+#endif
+
+
+}
+
+/**
+ * @brief Fast 64-bit (non-cryptographic) hash of one guest page.
+ * 
+ * This is an xxh3-style accumulate-and-scramble hash over 8 independent
+ * 64-bit lanes, vectorized with AVX2 when the CPU supports it (SSE2
+ * otherwise). Both versions give the same hashes.
+ * 
+ * @param page `PageCache::pageSize` bytes.
+ * @return uint64_t
+ */
+inline uint64_t hashPage(const uint8_t *page) {
+#ifdef GUESTUTIL_PAGE_HASH_X86
+  static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+  if (hasAVX2) return pagehash::hashPageAVX2(page);
+#endif
+  return pagehash::hashPageImpl(page);
+}
+
+enum PageChangeType {
+  /**
+   * @brief The content changed.
+   * 
+   */
+  PAGE_MODIFIED,
+  /**
+   * @brief Mapped to a different frame (content may or may not change).
+   * 
+   */
+  PAGE_REMAPPED,
+  PAGE_MAPPED,
+  PAGE_UNMAPPED
+};
+
+struct PageChange {
+  addr_t pageNum;
+  PageChangeType type;
+};
+
+/**
+ * @brief Hashes of every mapped page of a `layout::VirtRange`, and the pages
+ * changed since the previous snapshot.
+ * 
+ * Each snapshot walks the page tables once (see `layout::MappedExtents`) and
+ * hashes the mapped pages (see `hashPage`) with a `ParallelScanner`, so the
+ * memory itself is never copied and only the previous table of hashes is
+ * kept. Like `layout::MappedExtents`, a snapshot is tagged with the epoch of
+ * the page cache, and is meant to be taken once per pause (see `isStale` and
+ * `update`).
+ * 
+ * Pages that cannot be read are hashed as 0 and reported as modified when
+ * they become (un)readable.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * vm.pause();
+ * memory::PageHashSnapshot text(vmi, textRange);
+ * vm.resume();
+ * // ...
+ * vm.pause();
+ * text.update(vmi);
+ * for (const auto &change : text.getChanges()) {
+ *   std::cout << F_HEX(change.pageNum << PAGE_SHIFT) << std::endl;
+ * }
+ * ```
+ * 
+ */
+class PageHashSnapshot {
+public:
+  struct Entry {
+    addr_t pageNum;
+    addr_t gfn;
+    uint64_t hash;
+    bool readable;
+  };
+private:
+  layout::VirtRange range;
+  ParallelScanner scanner;
+  /**
+   * @brief Current hashes, sorted by page number.
+   * 
+   */
+  std::vector<Entry> entries;
+  std::vector<Entry> previous;
+  std::vector<PageChange> changes;
+  uint64_t epoch;
+
+  inline void take(vmi_instance_t vmi) {
+    epoch = PageCache::of(vmi).getEpoch();
+    layout::MappedExtents extents(vmi, range);
+    entries.clear();
+    entries.reserve(extents.getMappedPages());
+    extents.forEachMappedPage([this](addr_t pageNum, addr_t gfn) {
+      entries.push_back(Entry{pageNum, gfn, 0, false});
+      return false;
+    });
+    // Workers write to distinct entries, no lock needed
+    scanner.scan(vmi, extents,
+      [this](unsigned int, addr_t pageNum, addr_t, const uint8_t *page) {
+        auto it = std::lower_bound(
+          entries.begin(), entries.end(), pageNum,
+          [](const Entry &entry, addr_t pageNum) {
+            return entry.pageNum < pageNum;
+          });
+        it->hash = hashPage(page);
+        it->readable = true;
+        return false;
+      });
+  }
+
+  inline void diff() {
+    changes.clear();
+    auto prev = previous.begin();
+    auto cur = entries.begin();
+    while (prev != previous.end() || cur != entries.end()) {
+      if (cur == entries.end() || (
+        prev != previous.end() && prev->pageNum < cur->pageNum
+      )) {
+        changes.push_back(PageChange{prev->pageNum, PAGE_UNMAPPED});
+        prev++;
+      } else if (prev == previous.end() || cur->pageNum < prev->pageNum) {
+        changes.push_back(PageChange{cur->pageNum, PAGE_MAPPED});
+        cur++;
+      } else {
+        if (cur->gfn != prev->gfn) {
+          changes.push_back(PageChange{cur->pageNum, PAGE_REMAPPED});
+        } else if (
+          cur->readable != prev->readable || cur->hash != prev->hash
+        ) {
+          changes.push_back(PageChange{cur->pageNum, PAGE_MODIFIED});
+        }
+        prev++;
+        cur++;
+      }
+    }
+  }
+public:
+  /**
+   * @brief Take the first snapshot of `_range` (without changes).
+   * 
+   * @param vmi
+   * @param _range
+   * @param nThreads number of hashing threads (see `ParallelScanner`).
+   */
+  PageHashSnapshot(
+    vmi_instance_t vmi,
+    const layout::VirtRange &_range,
+    unsigned int nThreads = 1
+  ):
+    range(_range), scanner(nThreads), entries(), previous(), changes(),
+    epoch(0) {
+    take(vmi);
+  }
+
+  /**
+   * @brief Take a new snapshot, and compare it against the current one.
+   * 
+   * @param vmi
+   * @return const std::vector<PageChange>& the changes, sorted by page
+   * number.
+   */
+  inline const std::vector<PageChange> &rebuild(vmi_instance_t vmi) {
+    previous.swap(entries);
+    take(vmi);
+    diff();
+    DBG() << "PageHashSnapshot.rebuild(): " << F_DEC(entries.size())
+          << " page(s), " << F_DEC(changes.size()) << " change(s)"
+          << std::endl;
+    return changes;
+  }
+
+  inline bool isStale(vmi_instance_t vmi) const {
+    return epoch != PageCache::of(vmi).getEpoch();
+  }
+
+  /**
+   * @brief Take a new snapshot if the current one is stale.
+   * 
+   * @param vmi
+   * @return bool if a new snapshot is taken.
+   */
+  inline bool update(vmi_instance_t vmi) {
+    if (!isStale(vmi)) return false;
+    rebuild(vmi);
+    return true;
+  }
+
+  inline const layout::VirtRange &getRange() const {
+    return range;
+  }
+
+  inline const std::vector<Entry> &getEntries() const {
+    return entries;
+  }
+
+  /**
+   * @brief Get the pages changed between the last two snapshots.
+   * 
+   * @return const std::vector<PageChange>&
+   */
+  inline const std::vector<PageChange> &getChanges() const {
+    return changes;
+  }
+
+  /**
+   * @brief Get the hash of page `pageNum` in the current snapshot.
+   * 
+   * @param[in] pageNum
+   * @param[out] hash
+   * @return status_t `VMI_FAILURE` if the page is not mapped or not readable.
+   */
+  inline status_t tryGetHash(addr_t pageNum, uint64_t &hash) const {
+    auto it = std::lower_bound(
+      entries.begin(), entries.end(), pageNum,
+      [](const Entry &entry, addr_t pageNum) {
+        return entry.pageNum < pageNum;
+      });
+    if (it == entries.end() || it->pageNum != pageNum || !it->readable) {
+      return VMI_FAILURE;
+    }
+    hash = it->hash;
+    return VMI_SUCCESS;
+  }
+};
+
+
+}
+}
+
+
+#endif /* E5B07A2C_94D1_4F3E_8C66_1A2F9D7B3E08 */
@@ -0,0 +1,423 @@
+/**
+ * @file PageView.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief RAII views of guest frames mapped into our address space.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef C58E2D17_4A0B_4F6C_B3E9_71D0A5C9F284
+#define C58E2D17_4A0B_4F6C_B3E9_71D0A5C9F284
+
+
+#include <libvmi/libvmi.h>
+#include <sys/mman.h>  // munmap
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <memory>  // std::unique_ptr, std::shared_ptr
+#include <mutex>  // std::lock_guard
+#include <cstring>  // std::memcpy
+#include <algorithm>  // std::min
+
+
+namespace guestutil {
+namespace memory {
+
+
+class MemoryMapError: public MemoryError {
+public:
+  using MemoryError::MemoryError;
+
+  virtual const char *what() const throw() {
+    return "Failed to map guest memory";
+  }
+};
+
+/**
+ * @brief Read-only view of one guest frame.
+ * 
+ * The frame is mapped into our address space with `vmi_mmap_guest` and
+ * unmapped on destruction. If the driver cannot map guest memory (e.g.,
+ * LibVMI file mode), the frame is copied into a buffer owned by the view
+ * instead, so the view works the same either way.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::PageView page(vmi, memory::kvaToGFN(vmi, kva));
+ * auto pid = page.get<vmi_pid_t>(kva & memory::PageView::offsetMask);
+ * ```
+ * 
+ */
+class PageView {
+public:
+  static constexpr size_t pageSize = PageCache::pageSize;
+  static constexpr addr_t offsetMask = PageCache::pageMask;
+private:
+  const uint8_t *page;
+  /**
+   * @brief If `page` is mapped by `vmi_mmap_guest` (and must be unmapped,
+   * unless `run` owns it).
+   * 
+   */
+  bool mapped;
+  /**
+   * @brief Buffer for the fallback copy.
+   * 
+   */
+  std::unique_ptr<uint8_t[]> copy;
+  /**
+   * @brief Mapping of the whole run `page` is part of (see `tryMapRun`),
+   * unmapped as a whole with the last view of the run.
+   * 
+   */
+  std::shared_ptr<void> run;
+  addr_t gfn;
+
+  inline void release() {
+    if (mapped && page && !run) {
+      munmap(const_cast<uint8_t *>(page), pageSize);
+    }
+    page = nullptr;
+    mapped = false;
+    copy.reset();
+    run.reset();
+  }
+
+  /**
+   * @brief Adopt `_page` of the mapped run `_run`.
+   * 
+   */
+  PageView(addr_t _gfn, const uint8_t *_page, std::shared_ptr<void> _run):
+    page(_page), mapped(true), copy(), run(std::move(_run)), gfn(_gfn) {};
+public:
+  /**
+   * @brief Map the guest frame `gfn`.
+   * 
+   * @param vmi
+   * @param _gfn
+   */
+  PageView(vmi_instance_t vmi, addr_t _gfn):
+    page(nullptr), mapped(false), copy(), run(), gfn(_gfn) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    access_context_t ctx = {};
+#ifdef ACCESS_CONTEXT_VERSION
+    ctx.version = ACCESS_CONTEXT_VERSION;
+#endif
+    ctx.translate_mechanism = VMI_TM_NONE;
+    ctx.addr = gfn << PageCache::pageShift;
+    void *ptr = nullptr;
+    if (vmi_mmap_guest(vmi, &ctx, 1, &ptr) == VMI_SUCCESS && ptr) {
+      page = reinterpret_cast<const uint8_t *>(ptr);
+      mapped = true;
+      return;
+    }
+    DBG() << "PageView(): vmi_mmap_guest() failed for GFN "
+          << F_SHORT_HEX<addr_t>(gfn) << ", falling back to copying"
+          << std::endl;
+    copy.reset(new uint8_t[pageSize]);
+    size_t bytesRead = 0;
+    if (
+      vmi_read_pa(vmi, ctx.addr, pageSize, copy.get(), &bytesRead)
+        == VMI_FAILURE ||
+      bytesRead != pageSize
+    ) {
+      throw MemoryMapError(ctx.addr);
+    }
+    page = copy.get();
+  }
+
+  /**
+   * @brief Map the `nPages` guest frames from `gfn` with a single
+   * `vmi_mmap_guest` call, appending one view per frame to `views`.
+   * 
+   * The drivers map the run as one region, which is never split: the views
+   * share it and the last one unmaps it as a whole.
+   * 
+   * @param[in] vmi
+   * @param[in] gfn
+   * @param[in] nPages
+   * @param[out] views
+   * @return status_t `VMI_FAILURE` (and nothing appended) if any of the frames
+   * cannot be mapped, or the run is not mapped as one region, in which case
+   * map them one by one.
+   */
+  static status_t tryMapRun(
+    vmi_instance_t vmi, addr_t gfn, size_t nPages,
+    std::vector<PageView> &views
+  ) {
+    if (!nPages) return VMI_SUCCESS;
+    access_context_t ctx = {};
+#ifdef ACCESS_CONTEXT_VERSION
+    ctx.version = ACCESS_CONTEXT_VERSION;
+#endif
+    ctx.translate_mechanism = VMI_TM_NONE;
+    ctx.addr = gfn << PageCache::pageShift;
+    std::vector<void *> ptrs(nPages, nullptr);
+    {
+      std::lock_guard<VMILock> guard(VMILock::of(vmi));
+      if (vmi_mmap_guest(vmi, &ctx, nPages, ptrs.data()) == VMI_FAILURE) {
+        return VMI_FAILURE;
+      }
+    }
+    // Base of the region, if the frames mapped are laid out as one
+    uint8_t *base = nullptr;
+    bool contiguous = true;
+    bool complete = true;
+    for (size_t i = 0; i < nPages; i++) {
+      uint8_t *ptr = reinterpret_cast<uint8_t *>(ptrs[i]);
+      if (!ptr) {
+        complete = false;
+        continue;
+      }
+      if (!base) base = ptr - i * pageSize;
+      if (ptr != base + i * pageSize) contiguous = false;
+    }
+    if (!base) return VMI_FAILURE;
+    if (!contiguous) {
+      // Separate mappings, unmap them one by one
+      for (void *ptr : ptrs) {
+        if (ptr) munmap(ptr, pageSize);
+      }
+      return VMI_FAILURE;
+    }
+    size_t length = nPages * pageSize;
+    std::shared_ptr<void> region(base, [length](void *ptr) {
+      munmap(ptr, length);
+    });
+    if (!complete) return VMI_FAILURE;  // Unmapped as a whole by `region`
+    views.reserve(views.size() + nPages);
+    for (size_t i = 0; i < nPages; i++) {
+      views.push_back(PageView(gfn + i, base + i * pageSize, region));
+    }
+    return VMI_SUCCESS;
+  }
+
+  PageView(const PageView &) = delete;
+  PageView &operator=(const PageView &) = delete;
+
+  PageView(PageView &&another):
+    page(another.page), mapped(another.mapped),
+    copy(std::move(another.copy)), run(std::move(another.run)),
+    gfn(another.gfn) {
+    another.page = nullptr;
+    another.mapped = false;
+  }
+
+  PageView &operator=(PageView &&another) {
+    if (this != &another) {
+      release();
+      page = another.page;
+      mapped = another.mapped;
+      copy = std::move(another.copy);
+      run = std::move(another.run);
+      gfn = another.gfn;
+      another.page = nullptr;
+      another.mapped = false;
+    }
+    return *this;
+  }
+
+  ~PageView() {
+    release();
+  }
+
+  inline addr_t getGFN() const {
+    return gfn;
+  }
+
+  /**
+   * @brief If the frame is actually mapped (rather than copied).
+   * 
+   * @return bool
+   */
+  inline bool isZeroCopy() const {
+    return mapped;
+  }
+
+  inline const uint8_t *data() const {
+    return page;
+  }
+
+  inline size_t size() const {
+    return pageSize;
+  }
+
+  inline const uint8_t *begin() const {
+    return page;
+  }
+
+  inline const uint8_t *end() const {
+    return page + pageSize;
+  }
+
+  inline uint8_t operator[](size_t offset) const {
+    return page[offset];
+  }
+
+  /**
+   * @brief Extract a value of type `T` at `offset` of the frame.
+   * 
+   * @tparam T trivially copyable type.
+   * @param offset must satisfy `offset + sizeof(T) <= pageSize`.
+   * @return T
+   */
+  template <typename T>
+  inline T get(size_t offset) const {
+    T val;
+    std::memcpy(&val, page + offset, sizeof(T));
+    return val;
+  }
+};
+
+/**
+ * @brief Read-only view of a range of guest memory, made of one `PageView`
+ * per page touched.
+ * 
+ * Accesses that fall within one page are plain pointer arithmetic (see `at`);
+ * accesses that straddle pages are copied out (see `copy`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * auto view = memory::RangeView::ofKVA(vmi, task, taskSize);
+ * vmi_pid_t pid = view.get<vmi_pid_t>(task + pidOffset);
+ * const char *comm = reinterpret_cast<const char *>(
+ *   view.at(task + nameOffset, 16));  // `nullptr` if it straddles pages
+ * ```
+ * 
+ */
+class RangeView {
+private:
+  /**
+   * @brief Base address (page aligned) of the first page. Kernel virtual
+   * address for `ofKVA`, guest physical address for `ofGFN`.
+   * 
+   */
+  addr_t base;
+  std::vector<PageView> pages;
+
+  RangeView(addr_t _base): base(_base), pages() {};
+
+  inline size_t indexOf(addr_t addr) const {
+    return (addr - base) >> PageCache::pageShift;
+  }
+public:
+  /**
+   * @brief Map the frames backing the kernel virtual range
+   * `[kva, kva + count)`.
+   * 
+   * @param vmi
+   * @param kva
+   * @param count
+   * @return RangeView
+   */
+  static RangeView ofKVA(vmi_instance_t vmi, addr_t kva, size_t count) {
+    RangeView view(kva & ~PageView::offsetMask);
+    if (!count) return view;
+    addr_t last = (kva + count - 1) & ~PageView::offsetMask;
+    for (addr_t page = view.base; page <= last; page += PageView::pageSize) {
+      view.pages.emplace_back(vmi, kvaToGFN(vmi, page));
+    }
+    return view;
+  }
+
+  /**
+   * @brief Map `nPages` consecutive guest frames starting from `gfn`.
+   * 
+   * @param vmi
+   * @param gfn
+   * @param nPages
+   * @return RangeView
+   */
+  static RangeView ofGFN(vmi_instance_t vmi, addr_t gfn, size_t nPages) {
+    RangeView view(gfn << PageCache::pageShift);
+    if (PageView::tryMapRun(vmi, gfn, nPages, view.pages) == VMI_SUCCESS) {
+      return view;
+    }
+    for (size_t i = 0; i < nPages; i++) {
+      view.pages.emplace_back(vmi, gfn + i);
+    }
+    return view;
+  }
+
+  inline addr_t getBase() const {
+    return base;
+  }
+
+  inline addr_t getEnd() const {
+    return base + pages.size() * PageView::pageSize;
+  }
+
+  inline const std::vector<PageView> &getPages() const {
+    return pages;
+  }
+
+  /**
+   * @brief Get a pointer to `[addr, addr + count)` if it lies in a single
+   * page of this view.
+   * 
+   * @param addr
+   * @param count
+   * @return const uint8_t* `nullptr` if the region straddles pages or is out
+   * of the view.
+   */
+  inline const uint8_t *at(addr_t addr, size_t count) const {
+    if (addr < base || addr + count > getEnd()) return nullptr;
+    addr_t offset = addr & PageView::offsetMask;
+    if (offset + count > PageView::pageSize) return nullptr;
+    return pages[indexOf(addr)].data() + offset;
+  }
+
+  /**
+   * @brief Copy `[addr, addr + count)` into `buff`.
+   * 
+   * @param[in] addr
+   * @param[in] count
+   * @param[out] buff
+   */
+  inline void copy(addr_t addr, size_t count, void *buff) const {
+    if (addr < base || addr + count > getEnd()) {
+      throw MemoryReadError(addr, READ_KVA);
+    }
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buff);
+    while (count) {
+      addr_t offset = addr & PageView::offsetMask;
+      size_t n = std::min<size_t>(count, PageView::pageSize - offset);
+      std::memcpy(dst, pages[indexOf(addr)].data() + offset, n);
+      addr += n;
+      dst += n;
+      count -= n;
+    }
+  }
+
+  /**
+   * @brief Extract a value of type `T` at `addr`.
+   * 
+   * @tparam T trivially copyable type.
+   * @param addr
+   * @return T
+   */
+  template <typename T>
+  inline T get(addr_t addr) const {
+    T val;
+    const uint8_t *ptr = at(addr, sizeof(T));
+    if (ptr) std::memcpy(&val, ptr, sizeof(T));
+    else copy(addr, sizeof(T), &val);
+    return val;
+  }
+};
+
+
+}
+}
+
+
+#endif /* C58E2D17_4A0B_4F6C_B3E9_71D0A5C9F284 */
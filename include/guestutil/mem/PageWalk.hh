@@ -0,0 +1,236 @@
+/**
+ * @file PageWalk.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Single-pass page table walk over a virtual address range.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef E7A3D15C_92B4_4F08_A6C1_5D8E0B3F7A21
+#define E7A3D15C_92B4_4F08_A6C1_5D8E0B3F7A21
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <algorithm>  // std::min, std::max
+#include <mutex>  // std::lock_guard
+#include <cstdint>
+
+
+namespace guestutil {
+namespace memory {
+
+
+namespace pagewalk {
+
+
+constexpr unsigned int pageShift = TLB::pageShift;
+constexpr unsigned int levelBits = 9;
+constexpr size_t nEntries = size_t(1) << levelBits;
+constexpr unsigned int nLevels = 4;
+constexpr uint64_t presentBit = uint64_t(1) << 0;
+/**
+ * @brief The PS bit of PDPT and PD entries (1 GiB and 2 MiB pages).
+ * 
+ */
+constexpr uint64_t pageSizeBit = uint64_t(1) << 7;
+/**
+ * @brief Bits 12 to 51 of an entry.
+ * 
+ */
+constexpr uint64_t frameMask = 0x000ffffffffff000ull;
+
+/**
+ * @brief Get the number of virtual address bits translated by an entry of
+ * `level` (1 for PT, 4 for PML4).
+ * 
+ * @param level
+ * @return unsigned int
+ */
+constexpr unsigned int shiftOf(unsigned int level) {
+  return pageShift + levelBits * (level - 1);
+}
+
+/**
+ * @brief Sign-extend bit 47 of `va` to make it canonical.
+ * 
+ * @param va
+ * @return addr_t
+ */
+constexpr addr_t canonical(addr_t va) {
+  return (va & (addr_t(1) << 47)) ? (va | 0xffff000000000000ull) :
+    (va & 0x0000ffffffffffffull);
+}
+
+/**
+ * @brief Walk the table at `tableGPA` of `level`, which maps the virtual
+ * region starting from `tableBase`, for `[begin, end)`.
+ * 
+ * @return bool if `action` broke the walk.
+ */
+template <typename F>
+inline bool walkTable(
+  vmi_instance_t vmi,
+  addr_t tableGPA,
+  unsigned int level,
+  addr_t tableBase,
+  addr_t begin,
+  addr_t end,
+  F &action
+) {
+  uint64_t table[nEntries];
+  size_t bytesRead = 0;
+  status_t status = VMI_FAILURE;
+  {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    status = vmi_read_pa(vmi, tableGPA, sizeof(table), table, &bytesRead);
+  }
+  if (status == VMI_FAILURE || bytesRead != sizeof(table)) {
+    DBG() << "walkPageTables(): failed to read level " << F_DEC(level)
+          << " table at " << F_HEX<addr_t>(tableGPA) << std::endl;
+    return false;
+  }
+  unsigned int shift = shiftOf(level);
+  addr_t entrySize = addr_t(1) << shift;
+  size_t first = ((begin - tableBase) >> shift);
+  size_t last = ((end - 1 - tableBase) >> shift);
+  for (size_t i = first; i <= last; i++) {
+    uint64_t entry = table[i];
+    if (!(entry & presentBit)) continue;
+    addr_t entryBase = tableBase + (addr_t(i) << shift);
+    addr_t lo = std::max(begin, entryBase);
+    addr_t hi = std::min(end - 1, entryBase + (entrySize - 1)) + 1;
+    if (level == 1 || (level <= 3 && (entry & pageSizeBit))) {
+      addr_t frame = entry & frameMask & ~(entrySize - 1);
+      if (action(
+        canonical(lo), frame + (lo - entryBase), hi - lo
+      )) return true;
+    } else if (walkTable(
+      vmi, entry & frameMask, level - 1, entryBase, lo, hi, action
+    )) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+}
+
+/**
+ * @brief Walk the page tables of address space `dtb` once for the virtual
+ * range `[begin, end)`, calling `action` for each leaf mapping that
+ * intersects the range. Unmapped (non-present) entries are skipped as a
+ * whole at every level, so an empty PML4 entry costs one check rather than
+ * 2^27 translations.
+ * 
+ * Each page table page is read with a single `vmi_read_pa`. Page tables that
+ * cannot be read are treated as unmapped.
+ * 
+ * Only 4-level IA-32e paging is walked here. If the paging mode is different,
+ * or the DTB is unknown (0), the range is translated mapping by mapping
+ * through the software TLB instead, with the same callbacks.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::walkPageTables(vmi, dtb, begin, end,
+ *   [](addr_t va, addr_t gpa, addr_t size) {
+ *     // [va, va + size) is mapped to [gpa, gpa + size)
+ *     return false;
+ *   });
+ * ```
+ * 
+ * @tparam F callback function type,
+ * `bool (addr_t va, addr_t gpa, addr_t size)`, where `[va, va + size)` is
+ * the part of the leaf mapping inside the range and `gpa` is where `va` is
+ * mapped to. Return `true` to break.
+ * @param vmi
+ * @param dtb the DTB (CR3) of the address space.
+ * @param begin (inclusive)
+ * @param end (exclusive)
+ * @param action
+ * @return bool if `action` broke the walk.
+ */
+template <typename F>
+inline bool walkPageTables(
+  vmi_instance_t vmi,
+  addr_t dtb,
+  addr_t begin,
+  addr_t end,
+  F action
+) {
+  if (begin >= end) return false;
+  if (!dtb || vmi_get_page_mode(vmi, 0) != VMI_PM_IA32E) {
+    DBG() << "walkPageTables(): falling back to per-page translation"
+          << std::endl;
+    TLB &tlb = TLB::of(vmi);
+    for (addr_t va = begin; va < end;) {
+      addr_t gpa = 0, size = 0;
+      if (tlb.translate(dtb, va, gpa, size) == VMI_FAILURE) {
+        size = TLB::pageMask + 1;
+      } else if (action(
+        va, gpa, std::min(end - va, (va | (size - 1)) - va + 1)
+      )) {
+        return true;
+      }
+      // Skip to the end of the (huge) mapping
+      addr_t next = (va | (size - 1)) + 1;
+      if (next <= va) break;  // Wrapped around
+      va = next;
+    }
+    return false;
+  }
+  // Walk the lower and the higher canonical halves separately, on 48-bit
+  // addresses so that the walk of the PML4 starts from 0
+  constexpr addr_t lowerEnd = 0x0000800000000000ull;
+  constexpr addr_t higherBegin = 0xffff800000000000ull;
+  constexpr addr_t vaMask = 0x0000ffffffffffffull;
+  addr_t tableGPA = dtb & pagewalk::frameMask;
+  if (begin < lowerEnd && pagewalk::walkTable(
+    vmi, tableGPA, pagewalk::nLevels, 0,
+    begin, std::min(end, lowerEnd), action
+  )) return true;
+  if (end > higherBegin) {
+    addr_t lo = std::max(begin, higherBegin) & vaMask;
+    addr_t hi = ((end - 1) & vaMask) + 1;
+    return pagewalk::walkTable(
+      vmi, tableGPA, pagewalk::nLevels, 0, lo, hi, action);
+  }
+  return false;
+}
+
+/**
+ * @brief Same as `walkPageTables`, but walk the kernel address space (see
+ * `TLB::getKernelDTB`).
+ * 
+ * @tparam F
+ * @param vmi
+ * @param begin
+ * @param end
+ * @param action
+ * @return bool if `action` broke the walk.
+ */
+template <typename F>
+inline bool walkKernelPageTables(
+  vmi_instance_t vmi,
+  addr_t begin,
+  addr_t end,
+  F action
+) {
+  return walkPageTables(
+    vmi, TLB::of(vmi).getKernelDTB(), begin, end, action);
+}
+
+
+}
+}
+
+
+#endif /* E7A3D15C_92B4_4F08_A6C1_5D8E0B3F7A21 */
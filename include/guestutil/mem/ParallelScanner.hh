@@ -0,0 +1,303 @@
+/**
+ * @file ParallelScanner.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Scan guest pages with multiple worker threads.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef D2C8F4A1_3B7E_4E95_A0D6_9F1E5C7B2A48
+#define D2C8F4A1_3B7E_4E95_A0D6_9F1E5C7B2A48
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageView.hh>
+#include <guestutil/mem/layout.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <deque>  // std::deque
+#include <thread>  // std::thread
+#include <mutex>  // std::mutex, std::unique_lock
+#include <condition_variable>  // std::condition_variable
+#include <atomic>  // std::atomic
+#include <exception>  // std::exception_ptr
+#include <algorithm>  // std::max
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Run a callback on every page of a set of guest frames, in parallel.
+ * 
+ * LibVMI instances are not thread-safe, so all LibVMI calls (mapping the
+ * frames with `PageView`) are made by the calling thread, which maps the
+ * frames chunk by chunk (one `vmi_mmap_guest` per run of consecutive frames,
+ * see `PageView::tryMapRun`) and hands the chunks to the worker threads. The
+ * workers only touch the mapped memory, and unmap each chunk once it is
+ * scanned. At most `2 * nThreads` chunks are mapped at any time.
+ * 
+ * If the driver cannot map guest memory (e.g., LibVMI file mode on a memory
+ * dump), `PageView` copies the frames instead, so the scanner works the same
+ * offline. Frames that can be neither mapped nor read are skipped (see
+ * `getSkipped`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::ParallelScanner scanner;
+ * std::vector<size_t> nonZero(scanner.getThreads());
+ * scanner.scan(vmi, extents,
+ *   [&nonZero](unsigned int worker, addr_t pageNum, addr_t gfn,
+ *     const uint8_t *page) {
+ *     if (page[0]) nonZero[worker]++;  // One counter per worker, no lock
+ *     return false;
+ *   });
+ * ```
+ * 
+ */
+class ParallelScanner {
+private:
+  /**
+   * @brief A page to scan, `pageNum` is 0 when scanning frames directly.
+   * 
+   */
+  struct Item {
+    addr_t pageNum;
+    addr_t gfn;
+  };
+
+  struct Chunk {
+    std::vector<Item> items;
+    std::vector<PageView> views;
+  };
+
+  unsigned int nThreads;
+  size_t chunkPages;
+  size_t skipped;
+
+  /**
+   * @brief Map and scan the pages produced by `produce`, which is called with
+   * a callback `bool (addr_t pageNum, addr_t gfn)` (return `true` to stop
+   * producing).
+   * 
+   */
+  template <typename P, typename F>
+  inline void run(vmi_instance_t vmi, P produce, F &action) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Chunk> queue;
+    bool done = false;
+    std::atomic<bool> stop(false);
+    std::exception_ptr error = nullptr;
+    const size_t maxQueued = 2 * size_t(nThreads);
+
+    auto work = [&](unsigned int worker) {
+      for (;;) {
+        Chunk chunk;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          cv.wait(lock, [&] { return !queue.empty() || done; });
+          if (queue.empty()) return;
+          chunk = std::move(queue.front());
+          queue.pop_front();
+        }
+        cv.notify_all();  // Room for the producer
+        if (stop) continue;  // Drain (and unmap) the rest
+        try {
+          for (size_t i = 0; i < chunk.items.size(); i++) {
+            if (action(
+              worker, chunk.items[i].pageNum, chunk.items[i].gfn,
+              chunk.views[i].data()
+            )) {
+              stop = true;
+              break;
+            }
+          }
+        } catch (...) {
+          std::unique_lock<std::mutex> lock(mutex);
+          if (!error) error = std::current_exception();
+          stop = true;
+        }
+      }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < nThreads; i++) {
+      workers.emplace_back(work, i);
+    }
+
+    Chunk chunk;
+    std::vector<Item> pending;
+    // Map the pending pages, one `vmi_mmap_guest` per run of consecutive
+    // frames, falling back to one frame at a time for runs that fail
+    auto map = [&]() {
+      for (size_t i = 0; i < pending.size();) {
+        size_t j = i + 1;
+        while (
+          j < pending.size() && pending[j].gfn == pending[j - 1].gfn + 1
+        ) {
+          j++;
+        }
+        if (
+          PageView::tryMapRun(vmi, pending[i].gfn, j - i, chunk.views)
+            == VMI_SUCCESS
+        ) {
+          chunk.items.insert(
+            chunk.items.end(), pending.begin() + i, pending.begin() + j);
+        } else {
+          for (size_t k = i; k < j; k++) {
+            try {
+              chunk.views.emplace_back(vmi, pending[k].gfn);
+            } catch (const MemoryMapError &) {
+              skipped++;
+              continue;
+            }
+            chunk.items.push_back(pending[k]);
+          }
+        }
+        i = j;
+      }
+      pending.clear();
+    };
+    auto flush = [&]() {
+      map();
+      if (chunk.items.empty()) return;
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return queue.size() < maxQueued || stop; });
+      queue.push_back(std::move(chunk));
+      lock.unlock();
+      cv.notify_all();
+      chunk = Chunk();
+    };
+    try {
+      produce([&](addr_t pageNum, addr_t gfn) {
+        if (stop) return true;
+        pending.push_back(Item{pageNum, gfn});
+        if (pending.size() >= chunkPages) flush();
+        return false;
+      });
+      flush();
+    } catch (...) {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (!error) error = std::current_exception();
+      stop = true;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      done = true;
+    }
+    cv.notify_all();
+    for (auto &thread : workers) thread.join();
+    DBG() << "ParallelScanner.run(): " << F_DEC(nThreads) << " thread(s), "
+          << F_DEC(skipped) << " page(s) skipped" << std::endl;
+    if (error) std::rethrow_exception(error);
+  }
+public:
+  /**
+   * @brief Construct a new scanner.
+   * 
+   * @param _nThreads number of worker threads (0 for one per hardware
+   * thread).
+   * @param _chunkPages number of pages handed to a worker at once.
+   */
+  ParallelScanner(unsigned int _nThreads = 0, size_t _chunkPages = 256):
+    nThreads(_nThreads ? _nThreads :
+      std::max(1u, std::thread::hardware_concurrency())),
+    chunkPages(std::max<size_t>(1, _chunkPages)), skipped(0) {};
+
+  inline unsigned int getThreads() const {
+    return nThreads;
+  }
+
+  /**
+   * @brief Get the number of frames skipped by the last scan because they
+   * could not be mapped nor read.
+   * 
+   * @return size_t
+   */
+  inline size_t getSkipped() const {
+    return skipped;
+  }
+
+  /**
+   * @brief Scan every mapped page of `extents` (see `layout::MappedExtents`).
+   * 
+   * @tparam F callback function type, `bool (unsigned int worker,
+   * addr_t pageNum, addr_t gfn, const uint8_t *page)`, called concurrently
+   * from the worker threads (`worker` is in `[0, getThreads())`). `page`
+   * (`PageView::pageSize` bytes) is only valid during the call. Return `true`
+   * to stop the scan (pages already handed to other workers may still be
+   * scanned). Exceptions are rethrown once all the workers are stopped.
+   * @param vmi
+   * @param extents
+   * @param action
+   */
+  template <typename F>
+  inline void scan(
+    vmi_instance_t vmi,
+    const layout::MappedExtents &extents,
+    F action
+  ) {
+    skipped = 0;
+    run(vmi, [&extents](auto emit) {
+      extents.forEachMappedPage(emit);
+    }, action);
+  }
+
+  /**
+   * @brief Scan every mapped page of `range` (see `scan`).
+   * 
+   * @tparam F
+   * @param vmi
+   * @param range
+   * @param action
+   */
+  template <typename F>
+  inline void scan(
+    vmi_instance_t vmi,
+    const layout::VirtRange &range,
+    F action
+  ) {
+    scan(vmi, layout::MappedExtents(vmi, range), action);
+  }
+
+  /**
+   * @brief Scan the `nFrames` guest frames starting from `gfn` (`pageNum` is
+   * always 0, see `scan`).
+   * 
+   * @tparam F
+   * @param vmi
+   * @param gfn
+   * @param nFrames
+   * @param action
+   */
+  template <typename F>
+  inline void scanGFNs(
+    vmi_instance_t vmi,
+    addr_t gfn,
+    addr_t nFrames,
+    F action
+  ) {
+    skipped = 0;
+    run(vmi, [gfn, nFrames](auto emit) {
+      for (addr_t i = 0; i < nFrames; i++) {
+        if (emit(0, gfn + i)) break;
+      }
+    }, action);
+  }
+};
+
+
+}
+}
+
+
+#endif /* D2C8F4A1_3B7E_4E95_A0D6_9F1E5C7B2A48 */
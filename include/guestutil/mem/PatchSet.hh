@@ -0,0 +1,339 @@
+/**
+ * @file PatchSet.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Write-combining set of kernel memory patches with bulk rollback.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef C3E7A951_8F2D_4B60_9A14_D6B0E2F83C57
+#define C3E7A951_8F2D_4B60_9A14_D6B0E2F83C57
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <map>  // std::map
+#include <vector>  // std::vector
+#include <mutex>  // std::lock_guard
+#include <exception>
+#include <algorithm>  // std::min, std::max
+#include <cstring>  // std::memcpy
+
+
+namespace guestutil {
+namespace memory {
+
+
+class PatchSetError: public std::exception {};
+
+class PatchSetAlreadyAppliedError: public PatchSetError {
+public:
+  virtual const char *what() const throw() {
+    return "Patch set is already applied";
+  }
+};
+
+/**
+ * @brief A set of patches (writes) to kernel virtual memory, applied and
+ * rolled back as a whole.
+ * 
+ * Patches are grouped by guest page. Applying the set translates each page
+ * once, reads it once with `vmi_read_pa` (recording the original bytes), and
+ * writes the span covering all the patches of the page back with a single
+ * `vmi_write_pa`. Because the span may include bytes between patches, the
+ * guest must be paused while the set is applied or rolled back.
+ * 
+ * If a page fails, the pages already patched are rolled back and a
+ * `MemoryWriteError` is thrown, so the set is either fully applied or not
+ * applied at all. Overlapping patches are applied in the order they were
+ * added, and rolling back restores the bytes found before applying.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::PatchSet patches(vmi);
+ * for (addr_t addr : addrs) patches.add<uint8_t>(addr, 0xCC);
+ * patches.apply();  // One read and one write per page touched
+ * // ...
+ * patches.rollback();
+ * ```
+ * 
+ */
+class PatchSet {
+public:
+  static constexpr unsigned int pageShift = PageCache::pageShift;
+  static constexpr addr_t pageSize = PageCache::pageSize;
+  static constexpr addr_t pageMask = PageCache::pageMask;
+private:
+  /**
+   * @brief A patch, or the part of a patch in one page.
+   * 
+   */
+  struct Piece {
+    /**
+     * @brief Offset in the page.
+     * 
+     */
+    addr_t offset;
+    std::vector<uint8_t> data;
+    /**
+     * @brief Bytes found when the page was applied (before any piece).
+     * 
+     */
+    std::vector<uint8_t> original;
+  };
+
+  struct Page {
+    std::vector<Piece> pieces;
+    /**
+     * @brief Guest physical address of the page, valid when applied.
+     * 
+     */
+    addr_t gpa;
+    bool applied;
+    /**
+     * @brief The span covering all the pieces.
+     * 
+     */
+    addr_t begin;
+    addr_t end;
+  };
+
+  vmi_instance_t vmi;
+  /**
+   * @brief Patched pages keyed by (kernel virtual) page number.
+   * 
+   */
+  std::map<addr_t, Page> pages;
+  bool applied;
+
+  /**
+   * @brief Write `[page.begin, page.end)` of `buff` (a whole page) to the
+   * guest, and through to the page cache.
+   * 
+   */
+  inline status_t writeSpan(addr_t pageNum, Page &page, const uint8_t *buff) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    size_t count = page.end - page.begin;
+    size_t bytesWritten = 0;
+    addr_t kva = (pageNum << pageShift) + page.begin;
+    if (
+      vmi_write_pa(
+        vmi, page.gpa + page.begin, count,
+        const_cast<uint8_t *>(buff + page.begin), &bytesWritten
+      ) == VMI_FAILURE ||
+      bytesWritten != count
+    ) {
+      PageCache::of(vmi).invalidate(kva, count);
+      return VMI_FAILURE;
+    }
+    PageCache::of(vmi).update(kva, count, buff + page.begin);
+    return VMI_SUCCESS;
+  }
+
+  inline status_t applyPage(addr_t pageNum, Page &page) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    addr_t kva = pageNum << pageShift;
+    uint8_t buff[pageSize];
+    size_t bytesRead = 0;
+    // Never write through a stale translation (in event callbacks, the other
+    // vCPUs may have remapped the page, e.g., module text)
+    TLB::of(vmi).flushKernelPage(kva);
+    if (
+      tryKvaToGPA(vmi, kva, page.gpa) == VMI_FAILURE ||
+      vmi_read_pa(vmi, page.gpa, pageSize, buff, &bytesRead) == VMI_FAILURE ||
+      bytesRead != pageSize
+    ) {
+      return VMI_FAILURE;
+    }
+    for (Piece &piece : page.pieces) {
+      piece.original.assign(
+        buff + piece.offset, buff + piece.offset + piece.data.size());
+    }
+    for (Piece &piece : page.pieces) {
+      std::memcpy(buff + piece.offset, piece.data.data(), piece.data.size());
+    }
+    if (writeSpan(pageNum, page, buff) == VMI_FAILURE) return VMI_FAILURE;
+    page.applied = true;
+    return VMI_SUCCESS;
+  }
+
+  inline status_t rollbackPage(addr_t pageNum, Page &page) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    uint8_t buff[pageSize];
+    size_t bytesRead = 0;
+    if (
+      vmi_read_pa(vmi, page.gpa, pageSize, buff, &bytesRead) == VMI_FAILURE ||
+      bytesRead != pageSize
+    ) {
+      return VMI_FAILURE;
+    }
+    for (Piece &piece : page.pieces) {
+      std::memcpy(
+        buff + piece.offset, piece.original.data(), piece.original.size());
+    }
+    if (writeSpan(pageNum, page, buff) == VMI_FAILURE) return VMI_FAILURE;
+    page.applied = false;
+    return VMI_SUCCESS;
+  }
+public:
+  PatchSet(vmi_instance_t _vmi): vmi(_vmi), pages(), applied(false) {};
+
+  PatchSet(const PatchSet &) = delete;
+  PatchSet &operator=(const PatchSet &) = delete;
+
+  /**
+   * @brief Add a patch of `size` bytes from `data` at kernel virtual address
+   * `kva`. The patch set must not be applied.
+   * 
+   * @param kva
+   * @param data
+   * @param size
+   * @return PatchSet& this patch set.
+   */
+  inline PatchSet &add(addr_t kva, const void *data, size_t size) {
+    if (applied) throw PatchSetAlreadyAppliedError();
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+    while (size) {
+      addr_t offset = kva & pageMask;
+      size_t n = std::min<size_t>(size, pageSize - offset);
+      auto emplaceResult = pages.emplace(
+        kva >> pageShift, Page{{}, 0, false, offset, offset + n});
+      Page &page = emplaceResult.first->second;
+      page.begin = std::min(page.begin, offset);
+      page.end = std::max<addr_t>(page.end, offset + n);
+      page.pieces.push_back(Piece{offset, {src, src + n}, {}});
+      kva += n;
+      src += n;
+      size -= n;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Add a patch writing `val` at kernel virtual address `kva`.
+   * 
+   * @tparam T trivially copyable type.
+   * @param kva
+   * @param val
+   * @return PatchSet& this patch set.
+   */
+  template <typename T>
+  inline PatchSet &add(addr_t kva, const T &val) {
+    return add(kva, &val, sizeof(T));
+  }
+
+  inline bool isApplied() const {
+    return applied;
+  }
+
+  inline bool empty() const {
+    return pages.empty();
+  }
+
+  /**
+   * @brief Get the number of pages touched.
+   * 
+   * @return size_t
+   */
+  inline size_t getPages() const {
+    return pages.size();
+  }
+
+  /**
+   * @brief Apply all the patches.
+   * 
+   */
+  inline void apply() {
+    if (applied) throw PatchSetAlreadyAppliedError();
+    for (auto it = pages.begin(); it != pages.end(); it++) {
+      if (applyPage(it->first, it->second) == VMI_SUCCESS) continue;
+      addr_t failed = it->first << pageShift;
+      while (it != pages.begin()) {
+        it--;
+        if (rollbackPage(it->first, it->second) == VMI_FAILURE) {
+          std::cerr << "Warning: PatchSet failed to roll back page "
+            << F_HEX<addr_t>(it->first << pageShift) << std::endl;
+        }
+      }
+      throw MemoryWriteError(failed, WRITE_PATCH_SET);
+    }
+    applied = true;
+    DBG() << "PatchSet.apply(): " << F_DEC(pages.size()) << " page(s)"
+          << std::endl;
+  }
+
+  /**
+   * @brief Restore the original bytes of all the pages patched. Do nothing if
+   * the set is not applied.
+   * 
+   * Pages that fail are kept applied and the first failure is thrown as a
+   * `MemoryWriteError` (the rest of the pages are still rolled back), so
+   * `rollback` can be retried.
+   * 
+   */
+  inline void rollback() {
+    if (!applied) return;
+    addr_t failed = 0;
+    bool ok = true;
+    for (auto &entry : pages) {
+      Page &page = entry.second;
+      if (!page.applied) continue;
+      if (rollbackPage(entry.first, page) == VMI_FAILURE && ok) {
+        ok = false;
+        failed = entry.first << pageShift;
+      }
+    }
+    if (!ok) throw MemoryWriteError(failed, WRITE_PATCH_SET);
+    applied = false;
+  }
+
+  /**
+   * @brief Get the original bytes of `[kva, kva + size)` recorded when the
+   * set was applied, for the bytes covered by patches. Bytes not covered are
+   * left untouched in `buff`.
+   * 
+   * @param[in] kva
+   * @param[in] size
+   * @param[out] buff
+   * @return bool if the set is applied.
+   */
+  inline bool getOriginal(addr_t kva, size_t size, void *buff) const {
+    if (!applied) return false;
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buff);
+    addr_t end = kva + size;
+    for (
+      auto it = pages.lower_bound(kva >> pageShift);
+      it != pages.end() && (it->first << pageShift) < end;
+      it++
+    ) {
+      addr_t pageBase = it->first << pageShift;
+      for (const Piece &piece : it->second.pieces) {
+        addr_t lo = std::max(kva, pageBase + piece.offset);
+        addr_t hi = std::min(end, pageBase + piece.offset + piece.data.size());
+        if (lo >= hi) continue;
+        std::memcpy(
+          dst + (lo - kva),
+          piece.original.data() + (lo - pageBase - piece.offset),
+          hi - lo
+        );
+      }
+    }
+    return true;
+  }
+};
+
+
+}
+}
+
+
+#endif /* C3E7A951_8F2D_4B60_9A14_D6B0E2F83C57 */
@@ -0,0 +1,444 @@
+/**
+ * @file Prefetcher.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Asynchronous prefetch of guest kernel pages into the page cache.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef B1F4E8A3_7C29_4D05_9E6B_2A8C5D3F1E70
+#define B1F4E8A3_7C29_4D05_9E6B_2A8C5D3F1E70
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <deque>  // std::deque
+#include <memory>  // std::unique_ptr
+#include <thread>  // std::thread
+#include <mutex>  // std::mutex, std::unique_lock, std::lock_guard
+#include <condition_variable>  // std::condition_variable
+#include <cstring>  // std::memcpy
+#include <exception>  // std::exception
+#include <cstdint>
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Fetch guest kernel pages on a helper thread ahead of use, so that
+ * the following reads through the page cache (e.g., `readKVA` while the
+ * guest is paused) find them already copied into local memory.
+ * 
+ * While a prefetcher is alive, it serves the misses of the page cache of
+ * `vmi` (see `PageCache::setMissHandler`): a prefetched page is handed over
+ * to the cache, a page being fetched is waited for, and anything else is read
+ * as usual. LibVMI instances are not thread-safe, so the helper thread makes
+ * its LibVMI calls under the `VMILock` of `vmi`, which the library holds
+ * around each of its own LibVMI calls on `vmi` (reads through and around the
+ * page cache, `TLB` walks, writes, events). The helper thread translates with
+ * LibVMI directly and never touches the `TLB`. Code calling LibVMI directly
+ * on `vmi` while a prefetcher is alive takes the `VMILock` as well. Event
+ * callbacks run under the lock (inside `vmi_events_listen`), so the helper
+ * thread only fetches between them; prefetching pays off in pause sessions.
+ * 
+ * Prefetching only happens while the page cache is enabled (i.e., the guest
+ * is paused), and prefetched pages are dropped when the epoch of the cache
+ * changes. Disabling the cache (e.g., `vm::VM::resume()`) cancels the queued
+ * pages and waits for the one being fetched (see `cancel`), so the helper
+ * thread never races with the resume. A page whose fetch fails, including by
+ * an exception (e.g., `std::bad_alloc`), is read again on the calling thread
+ * on use.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * vm.pause();
+ * memory::Prefetcher prefetcher(vmi);
+ * memory::prefetch(vmi, nextTask, taskSize);  // Returns immediately
+ * // ... format the current task ...
+ * memory::readKVA(vmi, nextTask, taskSize, buff);  // Served by the prefetch
+ * ```
+ * 
+ */
+class Prefetcher {
+public:
+  static constexpr unsigned int pageShift = PageCache::pageShift;
+  static constexpr addr_t pageSize = PageCache::pageSize;
+
+  /**
+   * @brief Prefetch statistics.
+   * 
+   */
+  struct Stats {
+    /**
+     * @brief Pages queued.
+     * 
+     */
+    uint64_t queued;
+    /**
+     * @brief Cache misses served by a prefetched page.
+     * 
+     */
+    uint64_t served;
+    /**
+     * @brief Cache misses that had to wait for a page being fetched.
+     * 
+     */
+    uint64_t waited;
+  };
+private:
+  enum State {
+    QUEUED,
+    FETCHING,
+    DONE
+  };
+
+  struct Entry {
+    State state;
+    /**
+     * @brief Epoch of the page cache when queued.
+     * 
+     */
+    uint64_t epoch;
+    status_t status;
+    std::unique_ptr<uint8_t[]> data;
+  };
+
+  vmi_instance_t vmi;
+  /**
+   * @brief Kernel DTB, read once on the calling thread.
+   * 
+   */
+  addr_t dtb;
+  /**
+   * @brief Maximum number of pages queued or held.
+   * 
+   */
+  size_t maxPages;
+  /**
+   * @brief Serializes the LibVMI calls of the helper thread with the others.
+   * 
+   */
+  VMILock &vmiLock;
+  /**
+   * @brief Guards everything below.
+   * 
+   */
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<addr_t> queue;
+  std::unordered_map<addr_t, Entry> pages;
+  size_t fetching;
+  uint64_t epoch;
+  bool stopping;
+  Stats stats;
+  std::thread helper;
+
+  static std::unordered_map<vmi_instance_t, Prefetcher *> &registry() {
+    /**
+     * @brief Global per `vmi_instance_t` active prefetchers.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, Prefetcher *> prefetchers;
+    return prefetchers;
+  }
+
+  /**
+   * @brief Read a page on the helper thread (without the `TLB`), with
+   * `vmiLock` held.
+   * 
+   */
+  inline status_t fetch(addr_t pageNum, uint8_t *page) {
+    addr_t va = pageNum << pageShift;
+    addr_t gpa = 0;
+    if (dtb) {
+      page_info_t info = {};
+      if (vmi_pagetable_lookup_extended(vmi, dtb, va, &info) == VMI_FAILURE) {
+        return VMI_FAILURE;
+      }
+      gpa = info.paddr;
+    } else if (vmi_translate_kv2p(vmi, va, &gpa) == VMI_FAILURE) {
+      return VMI_FAILURE;
+    }
+    size_t bytesRead = 0;
+    if (
+      vmi_read_pa(vmi, gpa, pageSize, page, &bytesRead) == VMI_FAILURE ||
+      bytesRead != pageSize
+    ) {
+      return VMI_FAILURE;
+    }
+    return VMI_SUCCESS;
+  }
+
+  inline void work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      cv.wait(lock, [this] { return !queue.empty() || stopping; });
+      if (stopping) return;
+      // Always `vmiLock` before `mutex`. Pages are only `FETCHING` while we
+      // hold `vmiLock`, so the calling thread never waits for them with it
+      lock.unlock();
+      std::lock_guard<VMILock> guard(vmiLock);
+      lock.lock();
+      if (stopping) return;
+      if (queue.empty()) {
+        cv.notify_all();  // For `wait()`
+        continue;
+      }
+      addr_t pageNum = queue.front();
+      queue.pop_front();
+      auto it = pages.find(pageNum);
+      // Taken over by a cache miss or dropped
+      if (it == pages.end() || it->second.state != QUEUED) {
+        if (queue.empty()) cv.notify_all();  // For `wait()`
+        continue;
+      }
+      it->second.state = FETCHING;
+      fetching++;
+      lock.unlock();
+      std::unique_ptr<uint8_t[]> data;
+      status_t status = VMI_FAILURE;
+      try {
+        data.reset(new uint8_t[pageSize]);
+        status = fetch(pageNum, data.get());
+      } catch (const std::exception &e) {
+        // Left to the cache miss, the helper thread keeps going
+        DBG() << "Prefetcher.work(): " << e.what() << std::endl;
+        data.reset();
+      }
+      lock.lock();
+      // Entries being fetched are never erased by others
+      Entry &entry = pages.at(pageNum);
+      entry.state = DONE;
+      entry.status = status;
+      entry.data = std::move(data);
+      fetching--;
+      cv.notify_all();
+    }
+  }
+
+  /**
+   * @brief Drop everything queued or fetched in an old epoch.
+   * 
+   */
+  inline void purge() {
+    queue.clear();
+    for (auto it = pages.begin(); it != pages.end();) {
+      if (it->second.state != FETCHING) it = pages.erase(it);
+      else it++;
+    }
+  }
+
+  /**
+   * @brief Drop the fetched pages that have not been used.
+   * 
+   */
+  inline void evict() {
+    for (auto it = pages.begin(); it != pages.end();) {
+      if (it->second.state == DONE) it = pages.erase(it);
+      else it++;
+    }
+  }
+
+  /**
+   * @brief The miss handler of the page cache (on the calling thread).
+   * 
+   */
+  inline status_t onMiss(addr_t pageNum, uint8_t *page) {
+    PageCache &cache = PageCache::of(vmi);
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      auto it = pages.find(pageNum);
+      if (it != pages.end()) {
+        if (it->second.state == FETCHING) {
+          stats.waited++;
+          cv.wait(lock, [this, pageNum] {
+            return pages.at(pageNum).state == DONE;
+          });
+          it = pages.find(pageNum);
+        }
+        Entry &entry = it->second;
+        bool ok = entry.state == DONE && entry.status == VMI_SUCCESS &&
+          entry.epoch == cache.getEpoch();
+        if (ok) std::memcpy(page, entry.data.get(), pageSize);
+        // Queued entries are simply taken over (the helper skips them)
+        pages.erase(it);
+        if (ok) {
+          stats.served++;
+          return VMI_SUCCESS;
+        }
+      }
+    }
+    return cache.fetch(pageNum, page);
+  }
+
+  Prefetcher(Prefetcher&) = delete;
+  Prefetcher(Prefetcher&&) = delete;
+public:
+  /**
+   * @brief Start prefetching for `vmi`, replacing the prefetcher of `vmi` if
+   * any.
+   * 
+   * @param _vmi
+   * @param _maxPages maximum number of pages queued or held.
+   */
+  Prefetcher(vmi_instance_t _vmi, size_t _maxPages = 256):
+    vmi(_vmi), dtb(TLB::of(_vmi).getKernelDTB()),
+    maxPages(_maxPages ? _maxPages : 1), vmiLock(VMILock::of(_vmi)),
+    mutex(), cv(), queue(), pages(), fetching(0),
+    epoch(PageCache::of(_vmi).getEpoch()), stopping(false), stats{0, 0, 0},
+    helper() {
+    helper = std::thread(&Prefetcher::work, this);
+    registry()[vmi] = this;
+    PageCache &cache = PageCache::of(vmi);
+    cache.setMissHandler([this](addr_t pageNum, uint8_t *page) {
+      return onMiss(pageNum, page);
+    });
+    cache.setDisableHandler([this]() {
+      cancel();
+    });
+  }
+
+  ~Prefetcher() {
+    auto &prefetchers = registry();
+    auto it = prefetchers.find(vmi);
+    if (it != prefetchers.end() && it->second == this) {
+      prefetchers.erase(it);
+      PageCache &cache = PageCache::of(vmi);
+      cache.setMissHandler(nullptr);
+      cache.setDisableHandler(nullptr);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    // The helper thread may be waiting for `vmiLock` (e.g., when destroyed in
+    // an event callback), but no longer calls LibVMI once it gets it
+    size_t depth = vmiLock.unlockAll();
+    helper.join();
+    vmiLock.relock(depth);
+  }
+
+  /**
+   * @brief Get the active prefetcher of `vmi`.
+   * 
+   * @param vmi
+   * @return Prefetcher* `nullptr` if there is none.
+   */
+  static Prefetcher *of(vmi_instance_t vmi) {
+    auto &prefetchers = registry();
+    auto it = prefetchers.find(vmi);
+    return it == prefetchers.end() ? nullptr : it->second;
+  }
+
+  /**
+   * @brief Queue the pages touched by `[kva, kva + count)` that are not
+   * cached yet. Do nothing if the page cache is disabled. Pages beyond the
+   * capacity are not queued.
+   * 
+   * @param kva
+   * @param count
+   */
+  inline void prefetch(addr_t kva, size_t count) {
+    PageCache &cache = PageCache::of(vmi);
+    if (!count || !cache.isEnabled()) return;
+    bool queued = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (epoch != cache.getEpoch()) {
+        purge();
+        epoch = cache.getEpoch();
+      }
+      addr_t endPage = (kva + count - 1) >> pageShift;
+      for (addr_t pageNum = kva >> pageShift; pageNum <= endPage; pageNum++) {
+        if (cache.isCached(pageNum << pageShift)) continue;
+        if (pages.size() >= maxPages) evict();
+        if (pages.size() >= maxPages) break;
+        if (!pages.emplace(pageNum, Entry{QUEUED, epoch, VMI_FAILURE, nullptr})
+          .second) continue;
+        queue.push_back(pageNum);
+        stats.queued++;
+        queued = true;
+      }
+    }
+    if (queued) cv.notify_all();
+  }
+
+  /**
+   * @brief Wait until no page is queued or being fetched. If the calling
+   * thread holds the `VMILock` of `vmi` (e.g., in an event callback), the
+   * helper thread cannot fetch, so the queued pages are dropped instead and
+   * left to the cache misses.
+   * 
+   */
+  inline void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (vmiLock.isHeld()) {
+      queue.clear();
+      for (auto it = pages.begin(); it != pages.end();) {
+        if (it->second.state == QUEUED) it = pages.erase(it);
+        else it++;
+      }
+    }
+    cv.wait(lock, [this] { return queue.empty() && !fetching; });
+  }
+
+  /**
+   * @brief Drop the queued and fetched pages, and wait for the pages being
+   * fetched, i.e., until the helper thread no longer uses `vmi`.
+   * 
+   */
+  inline void cancel() {
+    std::unique_lock<std::mutex> lock(mutex);
+    purge();
+    cv.wait(lock, [this] { return !fetching; });
+    evict();
+  }
+
+  inline Stats getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+  }
+};
+
+/**
+ * @brief Prefetch `[kva, kva + count)` with the active prefetcher of `vmi`
+ * (see `Prefetcher`). Do nothing if there is none.
+ * 
+ * @param vmi
+ * @param kva
+ * @param count
+ */
+inline void prefetch(vmi_instance_t vmi, addr_t kva, size_t count) {
+  Prefetcher *prefetcher = Prefetcher::of(vmi);
+  if (prefetcher) prefetcher->prefetch(kva, count);
+}
+
+/**
+ * @brief Cancel the prefetches of the active prefetcher of `vmi` (see
+ * `Prefetcher::cancel`). Do nothing if there is none.
+ * 
+ * @param vmi
+ */
+inline void cancelPrefetch(vmi_instance_t vmi) {
+  Prefetcher *prefetcher = Prefetcher::of(vmi);
+  if (prefetcher) prefetcher->cancel();
+}
+
+
+}
+}
+
+
+#endif /* B1F4E8A3_7C29_4D05_9E6B_2A8C5D3F1E70 */
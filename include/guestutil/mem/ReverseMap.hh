@@ -0,0 +1,424 @@
+/**
+ * @file ReverseMap.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Reverse index from guest frames to the kernel virtual addresses
+ * mapping them.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef B4E91C07_6D2A_4F53_8E1B_0A7C3D5F9E62
+#define B4E91C07_6D2A_4F53_8E1B_0A7C3D5F9E62
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem/PageWalk.hh>
+#include <guestutil/mem/TLB.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <memory>  // std::unique_ptr
+#include <vector>  // std::vector
+#include <algorithm>  // std::sort, std::upper_bound, std::unique
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Per `vmi_instance_t` reverse map from GFNs to the kernel virtual
+ * addresses mapping them (e.g., both the direct map and a vmalloc alias).
+ * 
+ * The index is built from a single walk of the kernel page tables (see
+ * `walkKernelPageTables`) on first use. Leaf mappings that are contiguous in
+ * both address spaces are merged into runs. The runs of the direct map (the
+ * largest linear mapping, i.e., `va - (gfn << pageShift)` is the same for
+ * all of them) are kept apart, sorted and non-overlapping, and their VA is
+ * computed directly. The other (alias) runs are split into non-overlapping
+ * segments, each listing the runs covering it. A lookup is thus two binary
+ * searches plus one step per alias.
+ * 
+ * The index is a snapshot of the page tables and is NOT refreshed
+ * automatically (not even by `vm::VM::resume()`). Call `refresh()` for
+ * everything, or `refresh(begin, end)` for the part of the address space the
+ * guest may have remapped, e.g., the vmalloc or modules area.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * auto &rmap = memory::ReverseMap::of(vmi);
+ * rmap.forEachVA(gfn, [](addr_t kva) {
+ *   std::cout << F_HEX(kva) << std::endl;
+ *   return false;
+ * });
+ * ```
+ * 
+ */
+class ReverseMap {
+public:
+  static constexpr unsigned int pageShift = TLB::pageShift;
+  static constexpr addr_t pageSize = addr_t(1) << pageShift;
+  /**
+   * @brief Start of the kernel (higher) half of the address space.
+   * 
+   */
+  static constexpr addr_t kernelBegin = 0xffff800000000000ull;
+  /**
+   * @brief End of the kernel address space indexed (exclusive, the last page
+   * is not covered).
+   * 
+   */
+  static constexpr addr_t kernelEnd = ~addr_t(0) & ~(pageSize - 1);
+
+  /**
+   * @brief `pages` frames from `gfn` mapped at `va`.
+   * 
+   */
+  struct Run {
+    addr_t gfn;
+    addr_t va;
+    addr_t pages;
+  };
+private:
+  vmi_instance_t vmi;
+  bool built;
+  /**
+   * @brief Sorted by `gfn`, then `va`.
+   * 
+   */
+  std::vector<Run> runs;
+  /**
+   * @brief `pages` frames from `gfn` covered by the alias runs
+   * `aliases[first..first + count)`, sorted by VA.
+   * 
+   */
+  struct Segment {
+    addr_t gfn;
+    addr_t pages;
+    uint32_t first;
+    uint32_t count;
+  };
+  /**
+   * @brief The direct map runs, sorted by `gfn` (non-overlapping).
+   * 
+   */
+  std::vector<Run> directRuns;
+  /**
+   * @brief `va - (gfn << pageShift)` of the direct map runs.
+   * 
+   */
+  addr_t directDelta;
+  /**
+   * @brief Sorted by `gfn` (non-overlapping).
+   * 
+   */
+  std::vector<Segment> segments;
+  std::vector<Run> aliases;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<ReverseMap>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` reverse maps.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<ReverseMap>>
+      rmaps;
+    return rmaps;
+  }
+
+  ReverseMap(vmi_instance_t _vmi):
+    vmi(_vmi), built(false), runs(), directRuns(), directDelta(0),
+    segments(), aliases() {};
+
+  ReverseMap(ReverseMap&) = delete;
+  ReverseMap(ReverseMap&&) = delete;
+
+  /**
+   * @brief Walk `[begin, end)` and append its runs (unsorted).
+   * 
+   */
+  inline void collect(addr_t begin, addr_t end) {
+    size_t first = runs.size();
+    walkKernelPageTables(vmi, begin, end,
+      [this, first](addr_t va, addr_t gpa, addr_t size) {
+        addr_t gfn = gpa >> pageShift;
+        addr_t pages = size >> pageShift;
+        if (runs.size() > first) {
+          Run &last = runs.back();
+          if (
+            last.va + (last.pages << pageShift) == va &&
+            last.gfn + last.pages == gfn
+          ) {
+            last.pages += pages;
+            return false;
+          }
+        }
+        runs.push_back(Run{gfn, va, pages});
+        return false;
+      });
+  }
+
+  static inline addr_t deltaOf(const Run &run) {
+    return run.va - (run.gfn << pageShift);
+  }
+
+  /**
+   * @brief Split the alias runs into segments (`aliasRuns` sorted by `gfn`).
+   * 
+   */
+  inline void segment(const std::vector<Run> &aliasRuns) {
+    std::vector<addr_t> bounds;
+    bounds.reserve(aliasRuns.size() * 2);
+    for (const Run &run : aliasRuns) {
+      bounds.push_back(run.gfn);
+      bounds.push_back(run.gfn + run.pages);
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+    // Sweep the bounds, keeping the runs covering the current segment
+    std::vector<Run> active;
+    size_t next = 0;
+    for (size_t j = 0; j + 1 < bounds.size(); j++) {
+      addr_t begin = bounds[j];
+      active.erase(
+        std::remove_if(active.begin(), active.end(), [begin](const Run &run) {
+          return run.gfn + run.pages <= begin;
+        }),
+        active.end());
+      while (next < aliasRuns.size() && aliasRuns[next].gfn <= begin) {
+        active.push_back(aliasRuns[next++]);
+      }
+      if (active.empty()) continue;
+      // The order by VA is the same for every frame of the segment
+      std::sort(active.begin(), active.end(), [](const Run &a, const Run &b) {
+        return deltaOf(a) < deltaOf(b);
+      });
+      segments.push_back(Segment{
+        begin, bounds[j + 1] - begin, uint32_t(aliases.size()),
+        uint32_t(active.size())
+      });
+      aliases.insert(aliases.end(), active.begin(), active.end());
+    }
+  }
+
+  inline void reindex() {
+    std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b) {
+      return a.gfn != b.gfn ? a.gfn < b.gfn : a.va < b.va;
+    });
+    // The direct map is the linear mapping with the most pages
+    std::unordered_map<addr_t, addr_t> pagesByDelta;
+    directDelta = 0;
+    addr_t directPages = 0;
+    for (const Run &run : runs) {
+      addr_t &pages = pagesByDelta[deltaOf(run)];
+      pages += run.pages;
+      if (pages > directPages) {
+        directPages = pages;
+        directDelta = deltaOf(run);
+      }
+    }
+    directRuns.clear();
+    segments.clear();
+    aliases.clear();
+    std::vector<Run> aliasRuns;
+    for (const Run &run : runs) {
+      if (directPages && deltaOf(run) == directDelta) {
+        directRuns.push_back(run);
+      } else {
+        aliasRuns.push_back(run);
+      }
+    }
+    segment(aliasRuns);
+    built = true;
+    DBG() << "ReverseMap.reindex(): " << F_DEC(runs.size()) << " run(s), "
+          << F_DEC(directRuns.size()) << " in the direct map, "
+          << F_DEC(segments.size()) << " alias segment(s)" << std::endl;
+  }
+
+  /**
+   * @brief Find the entry of sorted `vec` covering `gfn`.
+   * 
+   */
+  template <typename T>
+  static inline const T *find(const std::vector<T> &vec, addr_t gfn) {
+    auto it = std::upper_bound(
+      vec.begin(), vec.end(), gfn,
+      [](addr_t gfn, const T &entry) { return gfn < entry.gfn; });
+    if (it == vec.begin()) return nullptr;
+    --it;
+    return gfn < it->gfn + it->pages ? &*it : nullptr;
+  }
+
+  inline void ensureBuilt() {
+    if (!built) refresh();
+  }
+public:
+  /**
+   * @brief Get the reverse map of `vmi` (created on first use, built on first
+   * lookup).
+   * 
+   * @param vmi
+   * @return ReverseMap&
+   */
+  static ReverseMap &of(vmi_instance_t vmi) {
+    auto &rmaps = registry();
+    auto it = rmaps.find(vmi);
+    if (it == rmaps.end()) {
+      it = rmaps.emplace(vmi, std::unique_ptr<ReverseMap>(new ReverseMap(vmi)))
+        .first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the reverse map of `vmi` (if any). Called before `vmi` is
+   * destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  /**
+   * @brief Rebuild the whole index.
+   * 
+   */
+  inline void refresh() {
+    runs.clear();
+    collect(kernelBegin, kernelEnd);
+    reindex();
+  }
+
+  /**
+   * @brief Rebuild the part of the index for the kernel virtual range
+   * `[begin, end)` (page aligned), keeping the rest.
+   * 
+   * @param begin
+   * @param end
+   */
+  inline void refresh(addr_t begin, addr_t end) {
+    if (!built) return refresh();
+    std::vector<Run> kept;
+    kept.reserve(runs.size());
+    for (const Run &run : runs) {
+      addr_t runEnd = run.va + (run.pages << pageShift);
+      if (runEnd <= begin || run.va >= end) {
+        kept.push_back(run);
+        continue;
+      }
+      // Keep the parts outside of the range
+      if (run.va < begin) {
+        kept.push_back(Run{run.gfn, run.va, (begin - run.va) >> pageShift});
+      }
+      if (runEnd > end) {
+        addr_t skipped = (end - run.va) >> pageShift;
+        kept.push_back(Run{run.gfn + skipped, end, run.pages - skipped});
+      }
+    }
+    runs.swap(kept);
+    collect(begin, end);
+    reindex();
+  }
+
+  /**
+   * @brief Clear the index, it will be rebuilt on the next lookup.
+   * 
+   */
+  inline void clear() {
+    runs.clear();
+    directRuns.clear();
+    segments.clear();
+    aliases.clear();
+    built = false;
+  }
+
+  inline const std::vector<Run> &getRuns() {
+    ensureBuilt();
+    return runs;
+  }
+
+  /**
+   * @brief Get the runs of the direct map (i.e., the guest RAM mapped by the
+   * kernel), sorted by GFN.
+   * 
+   * @return const std::vector<Run>& 
+   */
+  inline const std::vector<Run> &getDirectRuns() {
+    ensureBuilt();
+    return directRuns;
+  }
+
+  /**
+   * @brief Iterate over the kernel virtual addresses of every page mapping
+   * frame `gfn`, in ascending order.
+   * 
+   * @tparam F callback function type, `bool (addr_t kva)`, return `true` to
+   * break.
+   * @param gfn
+   * @param action
+   * @return bool if `action` broke the iteration.
+   */
+  template <typename F>
+  inline bool forEachVA(addr_t gfn, F action) {
+    ensureBuilt();
+    bool inDirectMap = find(directRuns, gfn) != nullptr;
+    addr_t directVA = (gfn << pageShift) + directDelta;
+    const Segment *seg = find(segments, gfn);
+    if (seg) {
+      for (uint32_t i = seg->first; i < seg->first + seg->count; i++) {
+        addr_t va = (gfn << pageShift) + deltaOf(aliases[i]);
+        if (inDirectMap && directVA < va) {
+          if (action(directVA)) return true;
+          inDirectMap = false;
+        }
+        if (action(va)) return true;
+      }
+    }
+    return inDirectMap && action(directVA);
+  }
+
+  /**
+   * @brief Get the kernel virtual addresses of every page mapping frame
+   * `gfn`, in ascending order.
+   * 
+   * @param gfn
+   * @return std::vector<addr_t>
+   */
+  inline std::vector<addr_t> getVAs(addr_t gfn) {
+    std::vector<addr_t> vas;
+    forEachVA(gfn, [&vas](addr_t va) {
+      vas.push_back(va);
+      return false;
+    });
+    return vas;
+  }
+
+  /**
+   * @brief Get the lowest kernel virtual address mapping frame `gfn`.
+   * 
+   * @param[in] gfn
+   * @param[out] va
+   * @return status_t `VMI_FAILURE` if the frame is not mapped.
+   */
+  inline status_t tryGetVA(addr_t gfn, addr_t &va) {
+    bool found = false;
+    forEachVA(gfn, [&va, &found](addr_t _va) {
+      va = _va;
+      found = true;
+      return true;
+    });
+    return found ? VMI_SUCCESS : VMI_FAILURE;
+  }
+};
+
+
+}
+}
+
+
+#endif /* B4E91C07_6D2A_4F53_8E1B_0A7C3D5F9E62 */
@@ -0,0 +1,199 @@
+/**
+ * @file StructSnapshot.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Read a kernel object in one shot and extract its fields locally.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef D9F4A6B3_2E71_4C0D_8A5F_6B3C9E2D1F08
+#define D9F4A6B3_2E71_4C0D_8A5F_6B3C9E2D1F08
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+
+#include <vector>  // std::vector
+#include <string_view>  // std::string_view
+#include <algorithm>  // std::min, std::max
+#include <cstring>  // std::memcpy, std::memchr
+#include <exception>
+
+
+namespace guestutil {
+namespace memory {
+
+
+class StructFieldError: public std::exception {
+public:
+  virtual const char *what() const throw() {
+    return "Field is not covered by the struct snapshot";
+  }
+};
+
+/**
+ * @brief The fields (offset and size) of a kernel struct we are interested
+ * in. Declared once, e.g., when the offsets are resolved.
+ * 
+ */
+class StructLayout {
+private:
+  /**
+   * @brief Offset of the first byte covered (inclusive).
+   * 
+   */
+  addr_t begin;
+  /**
+   * @brief Offset of the last byte covered (exclusive).
+   * 
+   */
+  addr_t end;
+public:
+  StructLayout(): begin(0), end(0) {};
+
+  /**
+   * @brief Declare a field.
+   * 
+   * @param offset offset of the field.
+   * @param size size of the field.
+   * @return StructLayout& this layout.
+   */
+  inline StructLayout &add(addr_t offset, size_t size) {
+    if (begin == end) {
+      begin = offset;
+      end = offset + size;
+    } else {
+      begin = std::min(begin, offset);
+      end = std::max<addr_t>(end, offset + size);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Declare a field of type `T`.
+   * 
+   * @tparam T
+   * @param offset
+   * @return StructLayout&
+   */
+  template <typename T>
+  inline StructLayout &add(addr_t offset) {
+    return add(offset, sizeof(T));
+  }
+
+  inline addr_t getBegin() const {
+    return begin;
+  }
+
+  inline addr_t getEnd() const {
+    return end;
+  }
+
+  /**
+   * @brief Get the number of bytes to read per object.
+   * 
+   * @return size_t
+   */
+  inline size_t getSpan() const {
+    return end - begin;
+  }
+};
+
+/**
+ * @brief Snapshot of a kernel object. The span covering all the fields of a
+ * `StructLayout` is read with a single `readKVA`, and the fields are then
+ * extracted from the local copy.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::StructLayout layout;
+ * layout.add<vmi_pid_t>(pidOffset).add(nameOffset, 16);
+ * memory::StructSnapshot task(layout);
+ * task.read(vmi, taskAddr);
+ * vmi_pid_t pid = task.get<vmi_pid_t>(pidOffset);
+ * std::string_view name = task.getStr(nameOffset, 16);
+ * ```
+ * 
+ */
+class StructSnapshot {
+protected:
+  StructLayout layout;
+  /**
+   * @brief Address of the object in the last `read`.
+   * 
+   */
+  addr_t addr;
+  std::vector<uint8_t> data;
+
+  inline const uint8_t *ptr(addr_t offset, size_t size) const {
+    if (offset < layout.getBegin() || offset + size > layout.getEnd()) {
+      throw StructFieldError();
+    }
+    return data.data() + (offset - layout.getBegin());
+  }
+public:
+  StructSnapshot(const StructLayout &_layout):
+    layout(_layout), addr(0), data(_layout.getSpan()) {};
+
+  /**
+   * @brief Read the object at kernel virtual address `objAddr`. The buffer is
+   * reused across reads.
+   * 
+   * @param vmi
+   * @param objAddr
+   * @return StructSnapshot& this snapshot.
+   */
+  inline StructSnapshot &read(vmi_instance_t vmi, addr_t objAddr) {
+    readKVA(vmi, objAddr + layout.getBegin(), data.size(), data.data());
+    addr = objAddr;
+    return *this;
+  }
+
+  inline addr_t getAddr() const {
+    return addr;
+  }
+
+  inline const StructLayout &getLayout() const {
+    return layout;
+  }
+
+  /**
+   * @brief Extract the field of type `T` at `offset`.
+   * 
+   * @tparam T trivially copyable type.
+   * @param offset
+   * @return T
+   */
+  template <typename T>
+  inline T get(addr_t offset) const {
+    T val;
+    std::memcpy(&val, ptr(offset, sizeof(T)), sizeof(T));
+    return val;
+  }
+
+  /**
+   * @brief Extract the (NUL-terminated, at most `maxLen` bytes) string field
+   * at `offset`.
+   * 
+   * @param offset
+   * @param maxLen
+   * @return std::string_view valid until the next `read`.
+   */
+  inline std::string_view getStr(addr_t offset, size_t maxLen) const {
+    const char *str = reinterpret_cast<const char *>(ptr(offset, maxLen));
+    const void *nul = std::memchr(str, 0, maxLen);
+    return std::string_view(
+      str, nul ? reinterpret_cast<const char *>(nul) - str : maxLen);
+  }
+};
+
+
+}
+}
+
+
+#endif /* D9F4A6B3_2E71_4C0D_8A5F_6B3C9E2D1F08 */
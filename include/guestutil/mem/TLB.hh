@@ -0,0 +1,407 @@
+/**
+ * @file TLB.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Software TLB for guest virtual to physical address translation.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef F1B7C2E9_83D4_4A6F_9C05_2E8A4D7B1C36
+#define F1B7C2E9_83D4_4A6F_9C05_2E8A4D7B1C36
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/offset/OffsetTable.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <memory>  // std::unique_ptr
+#include <mutex>  // std::lock_guard
+#include <cstdint>
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Per `vmi_instance_t` set-associative software TLB, keyed by
+ * (DTB, virtual page number).
+ * 
+ * Misses are resolved by `vmi_pagetable_lookup_extended` (a full page table
+ * walk) and filled in; failed translations are never cached. Like a hardware
+ * TLB, 2 MiB and 1 GiB mappings are kept in a separate, fully associative
+ * array with one entry per mapping, so that a scan over a huge page misses
+ * once rather than once per 4 KiB page. All the kernel translation
+ * helpers (`kvaToGPA` and everything layered on it) go through the TLB of
+ * their `vmi`.
+ * 
+ * Entries are tagged with a generation, and `flush` only starts a new one,
+ * so flushing is O(1). The TLB is flushed whenever the guest may have run
+ * since the last translation: by `vm::VM::pause()` / `resume()` (and their
+ * `try*` variants) and by `event::Loop` around every `vmi_events_listen`.
+ * Hence entries never outlive a pause session or a batch of event callbacks,
+ * e.g., when the guest changes its page tables or reuses the page directory
+ * of an exited process (same DTB) in the meantime.
+ * 
+ */
+class TLB {
+public:
+  /**
+   * @brief Same as `memory::PAGE_SHIFT` (x86 specific).
+   * 
+   */
+  static constexpr unsigned int pageShift = 12;
+  static constexpr addr_t pageMask = (addr_t(1) << pageShift) - 1;
+  static constexpr size_t nSets = 256;
+  static constexpr size_t nWays = 4;
+  static constexpr size_t nHugeEntries = 32;
+
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    /**
+     * @brief Misses that failed to translate.
+     * 
+     */
+    uint64_t faults;
+  };
+private:
+  struct Entry {
+    /**
+     * @brief Generation of the entry, stale unless `generation`.
+     * 
+     */
+    uint64_t gen;
+    addr_t dtb;
+    /**
+     * @brief Virtual page number, `invalidVPN` if the entry is empty.
+     * 
+     */
+    addr_t vpn;
+    /**
+     * @brief Physical frame number.
+     * 
+     */
+    addr_t pfn;
+  };
+
+  /**
+   * @brief Entry of a 2 MiB or 1 GiB mapping.
+   * 
+   */
+  struct HugeEntry {
+    uint64_t gen;
+    addr_t dtb;
+    /**
+     * @brief Virtual address of the mapping, `invalidVPN` if the entry is
+     * empty.
+     * 
+     */
+    addr_t va;
+    /**
+     * @brief Physical address of the mapping.
+     * 
+     */
+    addr_t pa;
+    addr_t size;
+  };
+
+  /**
+   * @brief Not a valid (canonical) virtual page number.
+   * 
+   */
+  static constexpr addr_t invalidVPN = ~addr_t(0);
+
+  vmi_instance_t vmi;
+  /**
+   * @brief The kernel DTB, 0 if LibVMI does not know it (then kernel
+   * translations are done by `vmi_translate_kv2p`).
+   * 
+   */
+  addr_t kernelDTB;
+  bool enabled;
+  /**
+   * @brief Current generation, entries of the others are stale (see `flush`).
+   * 
+   */
+  uint64_t generation;
+  Entry entries[nSets][nWays];
+  /**
+   * @brief Round-robin victim of each set.
+   * 
+   */
+  uint8_t victims[nSets];
+  HugeEntry hugeEntries[nHugeEntries];
+  size_t hugeVictim;
+  Stats stats;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<TLB>> &registry() {
+    /**
+     * @brief Global per `vmi_instance_t` TLBs.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<TLB>> tlbs;
+    return tlbs;
+  }
+
+  static inline size_t setOf(addr_t dtb, addr_t vpn) {
+    return (vpn ^ (dtb >> pageShift)) & (nSets - 1);
+  }
+
+  TLB(vmi_instance_t _vmi):
+    vmi(_vmi), kernelDTB(0), enabled(true), generation(0), entries(),
+    victims(), hugeEntries(), hugeVictim(0), stats{0, 0, 0} {
+    if (
+      offset::OffsetTable::of(vmi).tryGet(offset::KPGD, kernelDTB) ==
+        VMI_FAILURE
+    ) {
+      kernelDTB = 0;
+    }
+    flush();
+  }
+
+  TLB(TLB&) = delete;
+  TLB(TLB&&) = delete;
+
+  /**
+   * @brief Walk the page tables for `va`, also reporting the size of the
+   * mapping (always `pageSize` if `dtb` is unknown).
+   * 
+   */
+  inline status_t walk(addr_t dtb, addr_t va, addr_t &pa, addr_t &size) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    if (!dtb) {
+      size = pageMask + 1;
+      return vmi_translate_kv2p(vmi, va, &pa);
+    }
+    page_info_t info = {};
+    if (vmi_pagetable_lookup_extended(vmi, dtb, va, &info) == VMI_FAILURE) {
+      return VMI_FAILURE;
+    }
+    pa = info.paddr;
+    size = info.size == VMI_PS_UNKNOWN ? pageMask + 1 : addr_t(info.size);
+    return VMI_SUCCESS;
+  }
+public:
+  /**
+   * @brief Get the TLB of `vmi` (created on first use).
+   * 
+   * @param vmi
+   * @return TLB&
+   */
+  static TLB &of(vmi_instance_t vmi) {
+    auto &tlbs = registry();
+    auto it = tlbs.find(vmi);
+    if (it == tlbs.end()) {
+      it = tlbs.emplace(vmi, std::unique_ptr<TLB>(new TLB(vmi))).first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the TLB of `vmi` (if any). Called before `vmi` is destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  inline addr_t getKernelDTB() const {
+    return kernelDTB;
+  }
+
+  inline bool isEnabled() const {
+    return enabled;
+  }
+
+  /**
+   * @brief Enable or disable (and flush) the TLB. When disabled, every
+   * translation walks the page tables.
+   * 
+   * @param _enabled
+   */
+  inline void setEnabled(bool _enabled) {
+    enabled = _enabled;
+    flush();
+  }
+
+  inline Stats getStats() const {
+    return stats;
+  }
+
+  inline void resetStats() {
+    stats = {0, 0, 0};
+  }
+
+  /**
+   * @brief Drop all the entries (by starting a new generation).
+   * 
+   */
+  inline void flush() {
+    generation++;
+  }
+
+  /**
+   * @brief Drop all the entries of address space `dtb`.
+   * 
+   * @param dtb
+   */
+  inline void flushDTB(addr_t dtb) {
+    for (size_t set = 0; set < nSets; set++) {
+      for (size_t way = 0; way < nWays; way++) {
+        Entry &entry = entries[set][way];
+        if (entry.gen == generation && entry.dtb == dtb) {
+          entry.vpn = invalidVPN;
+        }
+      }
+    }
+    for (size_t i = 0; i < nHugeEntries; i++) {
+      HugeEntry &entry = hugeEntries[i];
+      if (entry.gen == generation && entry.dtb == dtb) entry.va = invalidVPN;
+    }
+  }
+
+  /**
+   * @brief Drop the entry of the page containing `va` in address space `dtb`.
+   * 
+   * @param dtb
+   * @param va
+   */
+  inline void flushPage(addr_t dtb, addr_t va) {
+    addr_t vpn = va >> pageShift;
+    Entry *set = entries[setOf(dtb, vpn)];
+    for (size_t way = 0; way < nWays; way++) {
+      if (
+        set[way].gen == generation && set[way].vpn == vpn &&
+        set[way].dtb == dtb
+      ) {
+        set[way].vpn = invalidVPN;
+      }
+    }
+    for (size_t i = 0; i < nHugeEntries; i++) {
+      HugeEntry &entry = hugeEntries[i];
+      if (
+        entry.gen == generation && entry.dtb == dtb &&
+        (va & ~(entry.size - 1)) == entry.va
+      ) {
+        entry.va = invalidVPN;
+      }
+    }
+  }
+
+  /**
+   * @brief Drop the entry of the kernel page containing `kva`.
+   * 
+   * @param kva
+   */
+  inline void flushKernelPage(addr_t kva) {
+    flushPage(kernelDTB, kva);
+  }
+
+  /**
+   * @brief Translate virtual address `va` of address space `dtb`, also
+   * reporting the size of the mapping containing it (4 KiB, 2 MiB or 1 GiB).
+   * 
+   * @param[in] dtb the DTB (CR3), or 0 for the kernel address space when the
+   * kernel DTB is unknown.
+   * @param[in] va
+   * @param[out] pa
+   * @param[out] size
+   * @return status_t
+   */
+  inline status_t translate(addr_t dtb, addr_t va, addr_t &pa, addr_t &size) {
+    if (!enabled) return walk(dtb, va, pa, size);
+    addr_t vpn = va >> pageShift;
+    size_t setIdx = setOf(dtb, vpn);
+    Entry *set = entries[setIdx];
+    for (size_t way = 0; way < nWays; way++) {
+      if (
+        set[way].gen == generation && set[way].vpn == vpn &&
+        set[way].dtb == dtb
+      ) {
+        stats.hits++;
+        pa = (set[way].pfn << pageShift) | (va & pageMask);
+        size = pageMask + 1;
+        return VMI_SUCCESS;
+      }
+    }
+    for (size_t i = 0; i < nHugeEntries; i++) {
+      HugeEntry &entry = hugeEntries[i];
+      if (
+        entry.gen == generation && entry.dtb == dtb &&
+        (va & ~(entry.size - 1)) == entry.va
+      ) {
+        stats.hits++;
+        pa = entry.pa | (va & (entry.size - 1));
+        size = entry.size;
+        return VMI_SUCCESS;
+      }
+    }
+    stats.misses++;
+    if (walk(dtb, va, pa, size) == VMI_FAILURE) {
+      stats.faults++;
+      return VMI_FAILURE;
+    }
+    if (size > pageMask + 1) {
+      hugeEntries[hugeVictim] =
+        HugeEntry{generation, dtb, va & ~(size - 1), pa & ~(size - 1), size};
+      hugeVictim = (hugeVictim + 1) % nHugeEntries;
+      return VMI_SUCCESS;
+    }
+    Entry &victim = set[victims[setIdx]];
+    victims[setIdx] = (victims[setIdx] + 1) % nWays;
+    victim = Entry{generation, dtb, vpn, pa >> pageShift};
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Translate virtual address `va` of address space `dtb`.
+   * 
+   * @param[in] dtb the DTB (CR3), or 0 for the kernel address space when the
+   * kernel DTB is unknown.
+   * @param[in] va
+   * @param[out] pa
+   * @return status_t
+   */
+  inline status_t translate(addr_t dtb, addr_t va, addr_t &pa) {
+    addr_t size = 0;
+    return translate(dtb, va, pa, size);
+  }
+
+  /**
+   * @brief Translate kernel virtual address `kva`.
+   * 
+   * @param[in] kva
+   * @param[out] pa
+   * @return status_t
+   */
+  inline status_t translateKernel(addr_t kva, addr_t &pa) {
+    return translate(kernelDTB, kva, pa);
+  }
+
+  /**
+   * @brief Translate kernel virtual address `kva`, also reporting the size of
+   * the mapping containing it.
+   * 
+   * @param[in] kva
+   * @param[out] pa
+   * @param[out] size
+   * @return status_t
+   */
+  inline status_t translateKernel(addr_t kva, addr_t &pa, addr_t &size) {
+    return translate(kernelDTB, kva, pa, size);
+  }
+};
+
+
+}
+}
+
+
+#endif /* F1B7C2E9_83D4_4A6F_9C05_2E8A4D7B1C36 */
@@ -46,6 +46,8 @@ public:
  * 2. Handle address space translation (this rely on the memory reading and
  *    writing functions provided by the caller as template arguments).
  * 
+ * See `TempMemSet` for modifying many kernel memory regions at once.
+ * 
  * Example usage:
  * 
  * ```C++
@@ -0,0 +1,213 @@
+/**
+ * @file TempMemSet.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Transactional set of temporary kernel memory modifications.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef F1A6C0D4_2E9B_4C37_B85D_7E3A9C1F0B64
+#define F1A6C0D4_2E9B_4C37_B85D_7E3A9C1F0B64
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PatchSet.hh>
+#include <guestutil/mem/TempMem.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief Temporary modifications of any number of kernel memory regions,
+ * applied and undone as a whole. Destruction of this will undo the
+ * modifications.
+ * 
+ * The modifications are written as a `PatchSet`, i.e., one translation, one
+ * read and one write per page touched, and the original bytes of all the
+ * regions are saved from what the `PatchSet` read (see
+ * `PatchSet::getOriginal`) into one contiguous buffer. Undoing restores the
+ * regions in the reverse order of `add`, so overlapping regions end up with
+ * the bytes found before `apply`. Either all the modifications are applied
+ * (undone) or none is, in which case a `MemoryWriteError` is thrown.
+ * 
+ * Same as `TempMem`, this DOES NOT handle accesses to the same memory by the
+ * guest, so the guest should be paused.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::TempMemSet tmpMem(vmi);
+ * for (unsigned int i = 0; i < nSyscalls; i++) {
+ *   tmpMem.add<addr_t>(sysCallTable + i * sizeof(addr_t), hook);
+ * }
+ * tmpMem.apply();
+ * // ...
+ * tmpMem.undo();  // Or let it go out of scope
+ * ```
+ * 
+ */
+class TempMemSet {
+private:
+  /**
+   * @brief A modification of `size` bytes at `kva`, whose new and old bytes
+   * are at `offset` of `values` and `oldValues`.
+   * 
+   */
+  struct Modification {
+    addr_t kva;
+    size_t size;
+    size_t offset;
+  };
+
+  vmi_instance_t vmi;
+  std::vector<Modification> mods;
+  /**
+   * @brief New bytes of all the modifications, back to back.
+   * 
+   */
+  std::vector<uint8_t> values;
+  /**
+   * @brief Saved old bytes of all the modifications, back to back (valid when
+   * applied).
+   * 
+   */
+  std::vector<uint8_t> oldValues;
+  bool applied;
+public:
+  TempMemSet() = delete;
+  TempMemSet(vmi_instance_t _vmi):
+    vmi(_vmi), mods(), values(), oldValues(), applied(false) {};
+
+  TempMemSet(const TempMemSet &) = delete;
+  TempMemSet &operator=(const TempMemSet &) = delete;
+
+  /**
+   * @brief Add a modification of `size` bytes from `data` at kernel virtual
+   * address `kva`. The set must not be applied.
+   * 
+   * @param kva
+   * @param data
+   * @param size
+   * @return TempMemSet& this set.
+   */
+  inline TempMemSet &add(addr_t kva, const void *data, size_t size) {
+    if (!kva) throw TempMemAddrError();
+    if (applied) throw TempMemAlreadyAppliedError();
+    if (!size) return *this;
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+    mods.push_back(Modification{kva, size, values.size()});
+    values.insert(values.end(), src, src + size);
+    return *this;
+  }
+
+  /**
+   * @brief Add a modification writing `val` at kernel virtual address `kva`.
+   * 
+   * @tparam T trivially copyable type.
+   * @param kva
+   * @param val
+   * @return TempMemSet& this set.
+   */
+  template <typename T>
+  inline TempMemSet &add(addr_t kva, const T &val) {
+    return add(kva, &val, sizeof(T));
+  }
+
+  /**
+   * @brief Remove all the modifications. The set must not be applied.
+   * 
+   */
+  inline void clear() {
+    if (applied) throw TempMemAlreadyAppliedError();
+    mods.clear();
+    values.clear();
+    oldValues.clear();
+  }
+
+  inline size_t size() const {
+    return mods.size();
+  }
+
+  inline bool isApplied() const {
+    return applied;
+  }
+
+  /**
+   * @brief Apply all the modifications, saving the old bytes of all the
+   * regions.
+   * 
+   */
+  inline void apply() {
+    DBG() << "TempMemSet.apply()" << std::endl
+          << "  modifications: " << F_DEC(mods.size()) << std::endl;
+    if (applied) throw TempMemAlreadyAppliedError();
+    if (mods.empty()) return;
+    PatchSet patches(vmi);
+    for (const Modification &mod : mods) {
+      patches.add(mod.kva, &values[mod.offset], mod.size);
+    }
+    patches.apply();
+    // The pages are read once by `apply`, take the old bytes from there
+    oldValues.resize(values.size());
+    for (const Modification &mod : mods) {
+      patches.getOriginal(mod.kva, mod.size, &oldValues[mod.offset]);
+    }
+    applied = true;
+  }
+
+  /**
+   * @brief Get the saved old bytes of the `i`-th modification (`size` bytes
+   * of the `add` call).
+   * 
+   * @param i
+   * @return const uint8_t* `nullptr` if not applied.
+   */
+  inline const uint8_t *getOldVal(size_t i) const {
+    return applied ? &oldValues[mods.at(i).offset] : nullptr;
+  }
+
+  /**
+   * @brief Undo all the modifications, in the reverse order.
+   * 
+   * @return bool if modifications are undone (`false` means the modifications
+   * were never made).
+   */
+  inline bool undo() {
+    if (!applied) return false;
+    DBG() << "TempMemSet.undo()" << std::endl
+          << "  modifications: " << F_DEC(mods.size()) << std::endl;
+    PatchSet patches(vmi);
+    // Later patches of a `PatchSet` win, so add them in the reverse order
+    for (auto it = mods.rbegin(); it != mods.rend(); it++) {
+      patches.add(it->kva, &oldValues[it->offset], it->size);
+    }
+    patches.apply();
+    applied = false;
+    return true;
+  }
+
+  ~TempMemSet() {
+    try {
+      undo();
+    } catch (const MemoryWriteError &err) {
+      std::cerr << "Warning: TempMemSet failed to undo modifications ("
+        << err.what() << ")" << std::endl;
+    }
+  }
+};
+
+
+}
+}
+
+
+#endif /* F1A6C0D4_2E9B_4C37_B85D_7E3A9C1F0B64 */
@@ -0,0 +1,159 @@
+/**
+ * @file batch.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Batched (scatter-gather) reads of kernel virtual memory.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A3C1F0D2_7B4E_4E8A_9D56_0C2E8F1B6A73
+#define A3C1F0D2_7B4E_4E8A_9D56_0C2E8F1B6A73
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageCache.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <mutex>  // std::lock_guard
+#include <algorithm>  // std::sort, std::unique, std::lower_bound
+#include <cstring>  // std::memcpy
+
+
+namespace guestutil {
+namespace memory {
+
+
+/**
+ * @brief One read of a batch: `count` bytes at kernel virtual address `kva`
+ * into `buff`.
+ * 
+ */
+struct ReadRequest {
+  addr_t kva;
+  size_t count;
+  void *buff;
+};
+
+/**
+ * @brief Read a batch of kernel virtual memory regions.
+ * 
+ * The pages touched by all the requests are sorted and deduplicated, each
+ * page is translated once, and runs of pages that are contiguous in both
+ * virtual and physical memory are read with a single `vmi_read_pa`. The
+ * requested bytes are then scattered into the destination buffers.
+ * 
+ * If the page cache of `vmi` is enabled, the requests are served by the cache
+ * instead (which reads each page at most once per epoch anyway).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * vmi_pid_t pid;
+ * addr_t next;
+ * memory::readMany(vmi, {
+ *   { task + pidOffset, sizeof(pid), &pid },
+ *   { task + tasksOffset, sizeof(next), &next }
+ * });
+ * ```
+ * 
+ * @param[in] vmi
+ * @param[in] requests the requests (in any order, may overlap).
+ */
+inline void readMany(
+  vmi_instance_t vmi,
+  const std::vector<ReadRequest> &requests
+) {
+  constexpr unsigned int shift = PageCache::pageShift;
+  constexpr addr_t pageSize = PageCache::pageSize;
+  constexpr addr_t pageMask = PageCache::pageMask;
+
+  PageCache &cache = PageCache::of(vmi);
+  if (cache.isEnabled()) {
+    for (auto &req : requests) {
+      if (cache.read(req.kva, req.count, req.buff) == VMI_FAILURE) {
+        throw MemoryReadError(req.kva, READ_MANY);
+      }
+    }
+    return;
+  }
+
+  // Step 1: collect the (sorted, unique) page numbers touched
+  std::vector<addr_t> pageNums;
+  for (auto &req : requests) {
+    if (!req.count) continue;
+    addr_t last = (req.kva + req.count - 1) >> shift;
+    for (addr_t pageNum = req.kva >> shift; pageNum <= last; pageNum++) {
+      pageNums.push_back(pageNum);
+    }
+  }
+  std::sort(pageNums.begin(), pageNums.end());
+  pageNums.erase(std::unique(pageNums.begin(), pageNums.end()), pageNums.end());
+
+  // Step 2: translate each page once, and read runs of pages that are
+  // contiguous in both address spaces at once
+  std::vector<uint8_t> pages(pageNums.size() * pageSize);
+  size_t runStart = 0;
+  addr_t runGPA = 0;
+  auto readRun = [vmi, &pages, &pageNums, &runStart, &runGPA](size_t runEnd) {
+    size_t count = (runEnd - runStart) * pageSize;
+    size_t bytesRead = 0;
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    if (
+      vmi_read_pa(
+        vmi, runGPA, count, pages.data() + runStart * pageSize, &bytesRead
+      ) == VMI_FAILURE ||
+      bytesRead != count
+    ) {
+      throw MemoryReadError(pageNums[runStart] << shift, READ_MANY);
+    }
+  };
+  for (size_t i = 0; i < pageNums.size(); i++) {
+    addr_t gpa = 0;
+    if (tryKvaToGPA(vmi, pageNums[i] << shift, gpa) == VMI_FAILURE) {
+      throw MemoryReadError(pageNums[i] << shift, READ_MANY);
+    }
+    if (
+      i == 0 ||
+      pageNums[i] != pageNums[i - 1] + 1 ||
+      gpa != runGPA + ((i - runStart) << shift)
+    ) {
+      if (i != 0) readRun(i);
+      runStart = i;
+      runGPA = gpa;
+    }
+  }
+  if (!pageNums.empty()) readRun(pageNums.size());
+  DBG() << "readMany(): " << F_DEC(requests.size()) << " request(s), "
+        << F_DEC(pageNums.size()) << " page(s)" << std::endl;
+
+  // Step 3: scatter
+  for (auto &req : requests) {
+    uint8_t *dst = reinterpret_cast<uint8_t *>(req.buff);
+    addr_t kva = req.kva;
+    size_t count = req.count;
+    while (count) {
+      size_t i = std::lower_bound(
+        pageNums.begin(), pageNums.end(), kva >> shift
+      ) - pageNums.begin();
+      addr_t offset = kva & pageMask;
+      size_t n = std::min<size_t>(count, pageSize - offset);
+      std::memcpy(dst, pages.data() + i * pageSize + offset, n);
+      kva += n;
+      dst += n;
+      count -= n;
+    }
+  }
+}
+
+
+}
+}
+
+
+#endif /* A3C1F0D2_7B4E_4E8A_9D56_0C2E8F1B6A73 */
@@ -0,0 +1,782 @@
+/**
+ * @file dump.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Sparse guest physical memory dumps: streaming writer and mmap-based
+ * read-only reader.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A9D3F6B2_1C84_4E7A_95F0_3B6E8D2C7A19
+#define A9D3F6B2_1C84_4E7A_95F0_3B6E8D2C7A19
+
+
+#include <libvmi/libvmi.h>
+#include <fcntl.h>  // open, O_*
+#include <unistd.h>  // pwrite, ftruncate, close
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/PageWalk.hh>
+#include <guestutil/mem/TLB.hh>
+#include <guestutil/mem/ReverseMap.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <string>  // std::string
+#include <vector>  // std::vector
+#include <deque>  // std::deque
+#include <thread>  // std::thread
+#include <mutex>  // std::mutex, std::unique_lock, std::lock_guard
+#include <condition_variable>  // std::condition_variable
+#include <exception>  // std::exception_ptr
+#include <memory>  // std::unique_ptr
+#include <utility>  // std::pair
+#include <algorithm>  // std::min, std::upper_bound
+#include <cerrno>  // errno
+#include <cstring>  // std::memcpy, std::memset, std::strerror
+#include <cstdlib>  // posix_memalign, std::free
+#include <cstdint>
+
+
+namespace guestutil {
+namespace memory {
+namespace dump {
+
+
+/**
+ * @brief The dump file format (all integers in host byte order).
+ * 
+ * ```
+ * +----------------------+ 0
+ * | Header (padded)      |
+ * +----------------------+ dataOffset (= pageSize)
+ * | Data pages           | nDataPages * pageSize, non-zero frames only
+ * +----------------------+ indexOffset
+ * | Index (padded)       | nRuns * sizeof(Run), sorted by GFN
+ * +----------------------+
+ * ```
+ * 
+ * Every section starts at a page boundary, so the file can be written with
+ * `O_DIRECT` and the data pages can be used in place once mapped. Frames
+ * that are not covered by any run could not be read and are not in the dump.
+ * 
+ */
+constexpr char magic[8] = {'B', 'V', 'M', 'I', 'D', 'M', 'P', '\0'};
+constexpr uint32_t version = 1;
+constexpr unsigned int pageShift = TLB::pageShift;
+constexpr size_t pageSize = size_t(1) << pageShift;
+/**
+ * @brief `Run::slot` of runs of zero frames (which have no data pages).
+ * 
+ */
+constexpr uint64_t zeroSlot = ~uint64_t(0);
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t pageShift;
+  /**
+   * @brief Kernel DTB (CR3) at the time of the dump, 0 if unknown.
+   * 
+   */
+  uint64_t kernelDTB;
+  /**
+   * @brief End (exclusive) of the guest frames dumped.
+   * 
+   */
+  uint64_t maxGFN;
+  uint64_t nRuns;
+  uint64_t nDataPages;
+  uint64_t dataOffset;
+  uint64_t indexOffset;
+};
+
+/**
+ * @brief `pages` frames from `gfn`, stored at data pages `[slot, slot +
+ * pages)` or all zero if `slot` is `zeroSlot`.
+ * 
+ */
+struct Run {
+  uint64_t gfn;
+  uint64_t pages;
+  uint64_t slot;
+};
+
+static_assert(sizeof(Header) <= pageSize, "Header does not fit in a page");
+
+class DumpError: public std::exception {
+private:
+  std::string msg;
+public:
+  DumpError(const std::string &_msg): msg(_msg) {};
+
+  virtual const char *what() const throw() {
+    return msg.c_str();
+  }
+};
+
+/**
+ * @brief Make a `DumpError` of the failed operation `op` on `path` from
+ * `errno`.
+ * 
+ */
+inline DumpError ioError(const char *op, const std::string &path) {
+  return DumpError(
+    std::string(op) + " " + path + ": " + std::strerror(errno));
+}
+
+inline bool isZeroPage(const uint8_t *page) {
+  const uint64_t *words = reinterpret_cast<const uint64_t *>(page);
+  for (size_t i = 0; i < pageSize / sizeof(uint64_t); i++) {
+    if (words[i]) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Write a dump file page by page, in ascending GFN order.
+ * 
+ * Non-zero pages are copied into a large page-aligned buffer, which is
+ * written out with a single `pwrite` when full. The file is opened with
+ * `O_DIRECT` if possible (and requested) to keep the dump out of the host
+ * page cache.
+ * 
+ */
+class DumpWriter {
+public:
+  /**
+   * @brief Default size of the write buffer.
+   * 
+   */
+  static constexpr size_t defaultBufferSize = size_t(4) << 20;
+private:
+  std::string path;
+  int fd;
+  uint8_t *buffer;
+  size_t bufferSize;
+  size_t buffered;
+  /**
+   * @brief File offset of the start of `buffer`.
+   * 
+   */
+  uint64_t offset;
+  std::vector<Run> runs;
+  uint64_t nDataPages;
+  /**
+   * @brief The next GFN expected to extend the last run.
+   * 
+   */
+  uint64_t nextGFN;
+
+  inline void writeAt(const uint8_t *data, size_t count, uint64_t at) {
+    while (count) {
+      ssize_t n = pwrite(fd, data, count, at);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        throw ioError("Failed to write", path);
+      }
+      data += n;
+      count -= n;
+      at += n;
+    }
+  }
+
+  /**
+   * @brief Write out the buffer, padded to a page boundary.
+   * 
+   */
+  inline void flush() {
+    if (!buffered) return;
+    size_t padded = (buffered + pageSize - 1) & ~(pageSize - 1);
+    std::memset(buffer + buffered, 0, padded - buffered);
+    writeAt(buffer, padded, offset);
+    offset += padded;
+    buffered = 0;
+  }
+
+  inline void append(const void *data, size_t count) {
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+    while (count) {
+      size_t n = std::min(count, bufferSize - buffered);
+      std::memcpy(buffer + buffered, src, n);
+      buffered += n;
+      src += n;
+      count -= n;
+      if (buffered == bufferSize) flush();
+    }
+  }
+
+  inline void extend(uint64_t gfn, uint64_t slot) {
+    if (!runs.empty() && gfn == nextGFN) {
+      Run &last = runs.back();
+      if (
+        (slot == zeroSlot && last.slot == zeroSlot) ||
+        (slot != zeroSlot && last.slot != zeroSlot &&
+          last.slot + last.pages == slot)
+      ) {
+        last.pages++;
+        nextGFN++;
+        return;
+      }
+    }
+    runs.push_back(Run{gfn, 1, slot});
+    nextGFN = gfn + 1;
+  }
+
+  inline void close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    std::free(buffer);
+    buffer = nullptr;
+  }
+public:
+  /**
+   * @brief Create (or truncate) the dump file at `_path`.
+   * 
+   * @param _path
+   * @param direct if to try writing with `O_DIRECT`.
+   * @param _bufferSize size of the write buffer (rounded up to pages).
+   */
+  DumpWriter(
+    const std::string &_path,
+    bool direct = true,
+    size_t _bufferSize = defaultBufferSize
+  ):
+    path(_path), fd(-1), buffer(nullptr),
+    bufferSize(
+      std::max(pageSize, (_bufferSize + pageSize - 1) & ~(pageSize - 1))),
+    buffered(0), offset(pageSize), runs(), nDataPages(0), nextGFN(0) {
+    int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+    if (direct) fd = open(path.c_str(), flags | O_DIRECT, 0644);
+#else
+    (void) direct;
+#endif
+    if (fd < 0) {
+      DBG() << "DumpWriter(): writing without O_DIRECT" << std::endl;
+      fd = open(path.c_str(), flags, 0644);
+    }
+    if (fd < 0) throw ioError("Failed to open", path);
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, pageSize, bufferSize)) {
+      close();
+      throw DumpError("Failed to allocate the dump buffer");
+    }
+    buffer = reinterpret_cast<uint8_t *>(ptr);
+  }
+
+  DumpWriter(const DumpWriter &) = delete;
+  DumpWriter &operator=(const DumpWriter &) = delete;
+
+  ~DumpWriter() {
+    close();
+  }
+
+  /**
+   * @brief Add frame `gfn`. Frames must be added in ascending order.
+   * 
+   * @param gfn
+   * @param page `pageSize` bytes.
+   */
+  inline void addPage(uint64_t gfn, const uint8_t *page) {
+    if (isZeroPage(page)) {
+      extend(gfn, zeroSlot);
+    } else {
+      append(page, pageSize);
+      extend(gfn, nDataPages++);
+    }
+  }
+
+  inline uint64_t getDataPages() const {
+    return nDataPages;
+  }
+
+  /**
+   * @brief Write the index and the header, and close the file.
+   * 
+   * @param kernelDTB
+   * @param maxGFN end (exclusive) of the frames dumped.
+   */
+  inline void finish(uint64_t kernelDTB, uint64_t maxGFN) {
+    flush();
+    uint64_t indexOffset = offset;
+    append(runs.data(), runs.size() * sizeof(Run));
+    flush();
+    std::memset(buffer, 0, pageSize);
+    Header header = {};
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.pageShift = pageShift;
+    header.kernelDTB = kernelDTB;
+    header.maxGFN = maxGFN;
+    header.nRuns = runs.size();
+    header.nDataPages = nDataPages;
+    header.dataOffset = pageSize;
+    header.indexOffset = indexOffset;
+    std::memcpy(buffer, &header, sizeof(header));
+    writeAt(buffer, pageSize, 0);
+    if (fsync(fd)) throw ioError("Failed to sync", path);
+    DBG() << "DumpWriter.finish(): " << F_DEC(runs.size()) << " run(s), "
+          << F_DEC(nDataPages) << " data page(s)" << std::endl;
+    close();
+  }
+};
+
+struct DumpStats {
+  /**
+   * @brief Frames dumped (including zero frames).
+   * 
+   */
+  uint64_t frames;
+  uint64_t dataPages;
+  /**
+   * @brief Frames that could not be read.
+   * 
+   */
+  uint64_t skipped;
+};
+
+/**
+ * @brief Get the ranges of guest RAM, as `[begin, end)` GFN pairs sorted by
+ * GFN, from the direct map of the kernel (see `ReverseMap::getDirectRuns`).
+ * 
+ * Holes (e.g., the PCI hole) are not mapped by the direct map. If it cannot
+ * be found, the whole range below `maxGFN` is returned.
+ * 
+ * @param vmi
+ * @param maxGFN
+ * @return std::vector<std::pair<uint64_t, uint64_t>>
+ */
+inline std::vector<std::pair<uint64_t, uint64_t>> getRAMRanges(
+  vmi_instance_t vmi, uint64_t maxGFN
+) {
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  for (const ReverseMap::Run &run : ReverseMap::of(vmi).getDirectRuns()) {
+    uint64_t begin = run.gfn;
+    uint64_t end = std::min<uint64_t>(run.gfn + run.pages, maxGFN);
+    if (begin >= end) continue;
+    if (!ranges.empty() && ranges.back().second >= begin) {
+      ranges.back().second = std::max(ranges.back().second, end);
+    } else {
+      ranges.emplace_back(begin, end);
+    }
+  }
+  if (ranges.empty()) ranges.emplace_back(0, maxGFN);
+  return ranges;
+}
+
+/**
+ * @brief Dump the guest RAM (see `getRAMRanges`) below the maximum physical
+ * address of `vmi` to `path`.
+ * 
+ * The frames are read by the calling thread (LibVMI instances are not
+ * thread-safe) `chunkPages` at a time, with a single `vmi_read_pa` per chunk
+ * (and per page only for chunks that cannot be read as a whole). The chunks
+ * are handed to a writer thread, which elides zero pages and writes the rest
+ * through a `DumpWriter`, so reading and writing overlap. The guest should
+ * be paused for a consistent dump.
+ * 
+ * @param vmi
+ * @param path
+ * @param chunkPages
+ * @param direct see `DumpWriter`.
+ * @return DumpStats
+ */
+inline DumpStats dumpMemory(
+  vmi_instance_t vmi,
+  const std::string &path,
+  size_t chunkPages = 256,
+  bool direct = true
+) {
+  struct Chunk {
+    uint64_t gfn;
+    size_t pages;
+    std::unique_ptr<uint8_t[]> data;
+    /**
+     * @brief If each page is read.
+     * 
+     */
+    std::vector<bool> valid;
+  };
+  const size_t maxQueued = 4;
+  chunkPages = std::max<size_t>(1, chunkPages);
+  uint64_t maxGFN = (vmi_get_max_physical_address(vmi) + pageSize - 1)
+    >> pageShift;
+  DumpWriter writer(path, direct);
+  DumpStats stats = {0, 0, 0};
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<Chunk> queue;
+  bool done = false;
+  bool stop = false;
+  std::exception_ptr error = nullptr;
+
+  std::thread writerThread([&]() {
+    for (;;) {
+      Chunk chunk;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return !queue.empty() || done; });
+        if (queue.empty()) return;
+        chunk = std::move(queue.front());
+        queue.pop_front();
+      }
+      cv.notify_all();  // Room for the reader
+      try {
+        for (size_t i = 0; i < chunk.pages; i++) {
+          if (!chunk.valid[i]) continue;
+          writer.addPage(chunk.gfn + i, chunk.data.get() + i * pageSize);
+        }
+      } catch (...) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+        stop = true;
+        queue.clear();
+        cv.notify_all();
+        return;
+      }
+    }
+  });
+
+  try {
+    bool stopped = false;
+    for (auto [begin, end] : getRAMRanges(vmi, maxGFN)) {
+      if (stopped) break;
+      for (uint64_t gfn = begin; gfn < end; gfn += chunkPages) {
+        Chunk chunk;
+        chunk.gfn = gfn;
+        chunk.pages = std::min<uint64_t>(chunkPages, end - gfn);
+        chunk.data.reset(new uint8_t[chunk.pages * pageSize]);
+        chunk.valid.assign(chunk.pages, true);
+        {
+          std::lock_guard<VMILock> guard(VMILock::of(vmi));
+          size_t bytesRead = 0;
+          if (
+            vmi_read_pa(
+              vmi, gfn << pageShift, chunk.pages * pageSize, chunk.data.get(),
+              &bytesRead
+            ) == VMI_FAILURE ||
+            bytesRead != chunk.pages * pageSize
+          ) {
+            // Keep the pages read, and retry the rest one by one
+            for (size_t i = bytesRead >> pageShift; i < chunk.pages; i++) {
+              bytesRead = 0;
+              if (
+                vmi_read_pa(
+                  vmi, (gfn + i) << pageShift, pageSize,
+                  chunk.data.get() + i * pageSize, &bytesRead
+                ) == VMI_FAILURE ||
+                bytesRead != pageSize
+              ) {
+                chunk.valid[i] = false;
+                stats.skipped++;
+              }
+            }
+          }
+        }
+        stats.frames += chunk.pages;
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return queue.size() < maxQueued || stop; });
+        if (stop) {
+          stopped = true;
+          break;
+        }
+        queue.push_back(std::move(chunk));
+        lock.unlock();
+        cv.notify_all();
+      }
+    }
+  } catch (...) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!error) error = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done = true;
+  }
+  cv.notify_all();
+  writerThread.join();
+  if (error) std::rethrow_exception(error);
+  stats.frames -= stats.skipped;
+  writer.finish(TLB::of(vmi).getKernelDTB(), maxGFN);
+  stats.dataPages = writer.getDataPages();
+  return stats;
+}
+
+/**
+ * @brief Read-only view of a dump file, mapped into our address space.
+ * 
+ * Offers the same reads and kernel address translation as the memory helpers
+ * (`tryReadKVA`, `tryKvaToGPA`, etc.), but served from the dump, so the
+ * analysis can be done offline. Translation only supports 4-level IA-32e
+ * paging (see `walkPageTables`). To run the memory helpers (and everything
+ * built on them, e.g. `process::ProcessList`) on a dump, write a raw view of
+ * it (see `writeRaw`) and open that with LibVMI in file mode.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::dump::DumpFile dump("guest.dump");
+ * auto pid = dump.read<vmi_pid_t>(initTask + pidOffset);
+ * ```
+ * 
+ */
+class DumpFile {
+private:
+  std::string path;
+  const uint8_t *base;
+  size_t size;
+  const Header *header;
+  const Run *runs;
+
+  static const uint8_t *zeroPage() {
+    alignas(pageSize) static const uint8_t zero[pageSize] = {0};
+    return zero;
+  }
+public:
+  DumpFile(const std::string &_path):
+    path(_path), base(nullptr), size(0), header(nullptr), runs(nullptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw ioError("Failed to open", path);
+    struct stat st;
+    if (fstat(fd, &st)) {
+      DumpError err = ioError("Failed to stat", path);
+      ::close(fd);
+      throw err;
+    }
+    size = st.st_size;
+    if (size < pageSize) {
+      ::close(fd);
+      throw DumpError("Not a dump file: " + path);
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) throw ioError("Failed to map", path);
+    base = reinterpret_cast<const uint8_t *>(ptr);
+    header = reinterpret_cast<const Header *>(base);
+    if (
+      std::memcmp(header->magic, magic, sizeof(magic)) ||
+      header->version != version ||
+      header->pageShift != pageShift ||
+      header->dataOffset + header->nDataPages * pageSize > header->indexOffset ||
+      header->indexOffset + header->nRuns * sizeof(Run) > size
+    ) {
+      munmap(const_cast<uint8_t *>(base), size);
+      throw DumpError("Not a dump file or unsupported version: " + path);
+    }
+    runs = reinterpret_cast<const Run *>(base + header->indexOffset);
+  }
+
+  DumpFile(const DumpFile &) = delete;
+  DumpFile &operator=(const DumpFile &) = delete;
+
+  ~DumpFile() {
+    munmap(const_cast<uint8_t *>(base), size);
+  }
+
+  inline const Header &getHeader() const {
+    return *header;
+  }
+
+  inline uint64_t getKernelDTB() const {
+    return header->kernelDTB;
+  }
+
+  /**
+   * @brief Get frame `gfn`.
+   * 
+   * @param gfn
+   * @return const uint8_t* `pageSize` bytes, or `nullptr` if the frame is not
+   * in the dump.
+   */
+  inline const uint8_t *getPage(uint64_t gfn) const {
+    const Run *end = runs + header->nRuns;
+    const Run *it = std::upper_bound(runs, end, gfn,
+      [](uint64_t gfn, const Run &run) { return gfn < run.gfn; });
+    if (it == runs) return nullptr;
+    it--;
+    if (gfn >= it->gfn + it->pages) return nullptr;
+    if (it->slot == zeroSlot) return zeroPage();
+    return base + header->dataOffset +
+      ((it->slot + (gfn - it->gfn)) << pageShift);
+  }
+
+  /**
+   * @brief Iterate over every frame in the dump, in ascending order.
+   * 
+   * @tparam F callback function type,
+   * `bool (uint64_t gfn, const uint8_t *page)`, return `true` to break.
+   * @param action
+   * @return bool if `action` broke the iteration.
+   */
+  template <typename F>
+  inline bool forEachPage(F action) const {
+    for (uint64_t i = 0; i < header->nRuns; i++) {
+      const Run &run = runs[i];
+      for (uint64_t j = 0; j < run.pages; j++) {
+        const uint8_t *page = run.slot == zeroSlot ? zeroPage() :
+          base + header->dataOffset + ((run.slot + j) << pageShift);
+        if (action(run.gfn + j, page)) return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Write a raw view of the dump to `rawPath`, i.e., a file where
+   * frame `gfn` is at offset `gfn * pageSize`, as LibVMI file mode expects.
+   * 
+   * Only the data pages are written, zero frames and holes are left sparse.
+   * Open it with `vm::VM` like a domain, e.g.
+   * `vm::VM vm("/path/to/guest.raw")` with an entry for it in `libvmi.conf`.
+   * 
+   * @param rawPath
+   */
+  inline void writeRaw(const std::string &rawPath) const {
+    int fd = open(rawPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw ioError("Failed to open", rawPath);
+    auto fail = [fd, &rawPath](const char *op) {
+      DumpError err = ioError(op, rawPath);
+      ::close(fd);
+      throw err;
+    };
+    if (ftruncate(fd, off_t(header->maxGFN << pageShift))) {
+      fail("Failed to truncate");
+    }
+    for (uint64_t i = 0; i < header->nRuns; i++) {
+      const Run &run = runs[i];
+      if (run.slot == zeroSlot) continue;
+      const uint8_t *data = base + header->dataOffset +
+        (run.slot << pageShift);
+      size_t count = run.pages << pageShift;
+      off_t at = off_t(run.gfn << pageShift);
+      while (count) {
+        ssize_t n = pwrite(fd, data, count, at);
+        if (n <= 0) fail("Failed to write");
+        data += n;
+        count -= n;
+        at += n;
+      }
+    }
+    ::close(fd);
+  }
+
+  /**
+   * @brief Read `count` bytes into `buff` from guest physical address `pa`.
+   * 
+   * @param[in] pa
+   * @param[in] count
+   * @param[out] buff
+   * @return status_t `VMI_FAILURE` if any page is not in the dump.
+   */
+  inline status_t tryReadPA(addr_t pa, size_t count, void *buff) const {
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buff);
+    while (count) {
+      const uint8_t *page = getPage(pa >> pageShift);
+      if (!page) return VMI_FAILURE;
+      size_t offset = pa & (pageSize - 1);
+      size_t n = std::min(count, pageSize - offset);
+      std::memcpy(dst, page + offset, n);
+      dst += n;
+      pa += n;
+      count -= n;
+    }
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Translate `va` of address space `dtb` by walking the page tables
+   * in the dump.
+   * 
+   * @param[in] dtb
+   * @param[in] va
+   * @param[out] pa
+   * @return status_t
+   */
+  inline status_t tryTranslate(addr_t dtb, addr_t va, addr_t &pa) const {
+    addr_t tableGPA = dtb & pagewalk::frameMask;
+    for (unsigned int level = pagewalk::nLevels; level >= 1; level--) {
+      unsigned int shift = pagewalk::shiftOf(level);
+      size_t index = (va >> shift) & (pagewalk::nEntries - 1);
+      uint64_t entry;
+      if (
+        tryReadPA(tableGPA + index * sizeof(entry), sizeof(entry), &entry)
+          == VMI_FAILURE ||
+        !(entry & pagewalk::presentBit)
+      ) {
+        return VMI_FAILURE;
+      }
+      if (level == 1 || (level <= 3 && (entry & pagewalk::pageSizeBit))) {
+        addr_t mask = (addr_t(1) << shift) - 1;
+        pa = (entry & pagewalk::frameMask & ~mask) | (va & mask);
+        return VMI_SUCCESS;
+      }
+      tableGPA = entry & pagewalk::frameMask;
+    }
+    return VMI_FAILURE;
+  }
+
+  inline status_t tryKvaToGPA(addr_t kva, addr_t &gpa) const {
+    return tryTranslate(header->kernelDTB, kva, gpa);
+  }
+
+  /**
+   * @brief Read `count` bytes into `buff` from kernel virtual address `kva`.
+   * 
+   * @param[in] kva
+   * @param[in] count
+   * @param[out] buff
+   * @return status_t
+   */
+  inline status_t tryReadKVA(addr_t kva, size_t count, void *buff) const {
+    uint8_t *dst = reinterpret_cast<uint8_t *>(buff);
+    while (count) {
+      addr_t gpa = 0;
+      size_t n = std::min(count, pageSize - (kva & (pageSize - 1)));
+      if (
+        tryKvaToGPA(kva, gpa) == VMI_FAILURE ||
+        tryReadPA(gpa, n, dst) == VMI_FAILURE
+      ) {
+        return VMI_FAILURE;
+      }
+      dst += n;
+      kva += n;
+      count -= n;
+    }
+    return VMI_SUCCESS;
+  }
+
+  inline void readKVA(addr_t kva, size_t count, void *buff) const {
+    if (tryReadKVA(kva, count, buff) == VMI_FAILURE) {
+      throw MemoryReadError(kva, READ_DUMP);
+    }
+  }
+
+  /**
+   * @brief Read a value of type `T` at kernel virtual address `kva`.
+   * 
+   * @tparam T trivially copyable type.
+   * @param kva
+   * @return T
+   */
+  template <typename T>
+  inline T read(addr_t kva) const {
+    T val;
+    readKVA(kva, sizeof(T), &val);
+    return val;
+  }
+};
+
+
+}
+}
+}
+
+
+#endif /* A9D3F6B2_1C84_4E7A_95F0_3B6E8D2C7A19 */
@@ -15,9 +15,11 @@
 #include <libvmi/libvmi.h>
 
 #include <guestutil/mem/translation.hh>
+#include <guestutil/mem/PageWalk.hh>
 #include <debug.hh>
 
 #include <vector>
+#include <algorithm>  // std::upper_bound
 #include <functional>  // std::function
 
 
@@ -37,7 +39,7 @@ private:
   addr_t size;
 public:
   explicit Range(addr_t _base, nullptr_t, addr_t _size):
-    base(_base), end(_base + size), size(_size) {};
+    base(_base), end(_base + _size), size(_size) {};
 
   explicit Range(addr_t _base, addr_t _end, nullptr_t):
     base(_base), end(_end), size(_end - _base) {};
@@ -146,6 +148,58 @@ public:
     return pageNums;
   }
 
+  /**
+   * @brief Iterate over all the leaf mappings of the pages touched by this
+   * range (kernel space only for now), with a single walk of the kernel page
+   * tables (see `walkKernelPageTables`). Unmapped regions are skipped.
+   * 
+   * @param vmi 
+   * @param action the action to do to each mapping, given the virtual address,
+   * the guest physical address it is mapped to, and the size of the mapping
+   * (clipped to the pages touched by this range), return `true` to break.
+   */
+  inline void forEachMapping(
+    vmi_instance_t vmi,
+    std::function<bool(addr_t, addr_t, addr_t)> action
+  ) {
+    walkKernelPageTables(
+      vmi, getStartPageNum() << PAGE_SHIFT, getEndPageNum() << PAGE_SHIFT,
+      action);
+  }
+
+  /**
+   * @brief Get the leaf mappings of the pages touched by this range (kernel
+   * space only for now), clipped to those pages. A 2 MiB or 1 GiB page is
+   * one mapping rather than 512 or 262144 pages.
+   * 
+   * @param vmi 
+   * @return std::vector<translation::Mapping> 
+   */
+  inline std::vector<translation::Mapping> getMappings(vmi_instance_t vmi) {
+    std::vector<translation::Mapping> mappings;
+    forEachMapping(vmi, [&mappings](addr_t va, addr_t gpa, addr_t size) {
+      mappings.emplace_back(va, gpa, size);
+      return false;
+    });
+    return mappings;
+  }
+
+  /**
+   * @brief Get the number of bytes of the pages touched by this range that
+   * are mapped (kernel space only for now).
+   * 
+   * @param vmi 
+   * @return addr_t 
+   */
+  inline addr_t getMappedSize(vmi_instance_t vmi) {
+    addr_t mapped = 0;
+    forEachMapping(vmi, [&mapped](addr_t, addr_t, addr_t size) {
+      mapped += size;
+      return false;
+    });
+    return mapped;
+  }
+
   /**
    * @brief Iterate over all GFNs touched by this range (kernel space only for
    * now).
@@ -157,12 +211,240 @@ public:
     vmi_instance_t vmi,
     std::function<bool(addr_t)> action
   ) {
-    forEachPageNum([vmi, &action](addr_t pageNum) {
-      return action(translation::PageNum(pageNum).toGFN(vmi));
+    addr_t nextPage = getStartPageNum();
+    bool stopped = false;
+    forEachMappedPage(
+      vmi, [&nextPage, &stopped, &action](addr_t pageNum, addr_t gfn) {
+        if (pageNum != nextPage) {
+          throw MemoryTranslationError(
+            KVA_TO_GFN, nextPage << PAGE_SHIFT, nullptr);
+        }
+        nextPage++;
+        return stopped = action(gfn);
+      });
+    // Trailing unmapped pages (only if the walk reached the end)
+    if (!stopped && nextPage != getEndPageNum()) {
+      throw MemoryTranslationError(KVA_TO_GFN, nextPage << PAGE_SHIFT, nullptr);
+    }
+  }
+
+  /**
+   * @brief Iterate over all **mapped** pages touched by this range (kernel
+   * space only for now), silently skipping the unmapped ones. Unlike
+   * `forEachGFN`, no exception is thrown for unmapped pages.
+   * 
+   * @param vmi 
+   * @param action the action to do to each mapped page, given the page number
+   * and the GFN, return `true` to break.
+   */
+  inline void forEachMappedPage(
+    vmi_instance_t vmi,
+    std::function<bool(addr_t, addr_t)> action
+  ) {
+    forEachMapping(vmi, [&action](addr_t va, addr_t gpa, addr_t size) {
+      addr_t pageNum = glaToPageNum(va);
+      addr_t gfn = gpaToGFN(gpa);
+      for (addr_t i = 0; i < (size >> PAGE_SHIFT); i++) {
+        if (action(pageNum + i, gfn + i)) return true;
+      }
+      return false;
     });
   }
 };
 
+/**
+ * @brief Run-length compressed index of the mapped parts of a `VirtRange`
+ * (kernel space only for now), i.e., which parts of, e.g., the modules area
+ * are actually mapped, and to where.
+ * 
+ * The index is built with a single walk of the kernel page tables. Pages that
+ * are contiguous in both address spaces are stored as one `Extent`, sorted by
+ * virtual address, so lookups are binary searches. The index is tagged with
+ * the epoch of the page cache of `vmi`, and is meant to be built once per
+ * pause (see `isStale` and `update`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * vm.pause();
+ * memory::layout::MappedExtents modules(vmi, modulesRange);
+ * modules.forEachExtent([](const auto &extent) {
+ *   // [extent.va, extent.va + (extent.pages << PAGE_SHIFT)) is mapped
+ *   return false;
+ * });
+ * ```
+ * 
+ */
+class MappedExtents {
+public:
+  /**
+   * @brief `pages` pages from `va` mapped to `pages` frames from `gfn`.
+   * 
+   */
+  struct Extent {
+    addr_t va;
+    addr_t gfn;
+    addr_t pages;
+
+    inline addr_t getEnd() const {
+      return va + (pages << PAGE_SHIFT);
+    }
+  };
+private:
+  VirtRange range;
+  std::vector<Extent> extents;
+  /**
+   * @brief Epoch of the page cache in which the index was built.
+   * 
+   */
+  uint64_t epoch;
+  addr_t mappedPages;
+public:
+  /**
+   * @brief Build the index of `_range`.
+   * 
+   * @param vmi 
+   * @param _range 
+   */
+  MappedExtents(vmi_instance_t vmi, const VirtRange &_range):
+    range(_range), extents(), epoch(0), mappedPages(0) {
+    rebuild(vmi);
+  }
+
+  /**
+   * @brief Rebuild the index with a fresh walk of the page tables.
+   * 
+   * @param vmi 
+   */
+  inline void rebuild(vmi_instance_t vmi) {
+    extents.clear();
+    mappedPages = 0;
+    epoch = PageCache::of(vmi).getEpoch();
+    range.forEachMapping(vmi, [this](addr_t va, addr_t gpa, addr_t size) {
+      addr_t gfn = gpaToGFN(gpa);
+      addr_t pages = size >> PAGE_SHIFT;
+      mappedPages += pages;
+      if (!extents.empty()) {
+        Extent &last = extents.back();
+        if (last.getEnd() == va && last.gfn + last.pages == gfn) {
+          last.pages += pages;
+          return false;
+        }
+      }
+      extents.push_back(Extent{va, gfn, pages});
+      return false;
+    });
+    DBG() << "MappedExtents.rebuild(): " << range << ", "
+          << F_DEC(extents.size()) << " extent(s), "
+          << F_DEC(mappedPages) << " page(s)" << std::endl;
+  }
+
+  /**
+   * @brief If the index was built before the last pause or resume (i.e., in
+   * another epoch of the page cache).
+   * 
+   * @param vmi 
+   * @return bool 
+   */
+  inline bool isStale(vmi_instance_t vmi) const {
+    return epoch != PageCache::of(vmi).getEpoch();
+  }
+
+  /**
+   * @brief Rebuild the index if it is stale.
+   * 
+   * @param vmi 
+   * @return bool if the index was rebuilt.
+   */
+  inline bool update(vmi_instance_t vmi) {
+    if (!isStale(vmi)) return false;
+    rebuild(vmi);
+    return true;
+  }
+
+  inline const VirtRange &getRange() const {
+    return range;
+  }
+
+  inline const std::vector<Extent> &getExtents() const {
+    return extents;
+  }
+
+  /**
+   * @brief Get the number of mapped pages.
+   * 
+   * @return addr_t 
+   */
+  inline addr_t getMappedPages() const {
+    return mappedPages;
+  }
+
+  /**
+   * @brief Find the extent containing `va`.
+   * 
+   * @param va 
+   * @return const Extent* `nullptr` if `va` is not mapped (or out of range).
+   */
+  inline const Extent *find(addr_t va) const {
+    auto it = std::upper_bound(
+      extents.begin(), extents.end(), va,
+      [](addr_t va, const Extent &extent) { return va < extent.va; }
+    );
+    if (it == extents.begin()) return nullptr;
+    const Extent &extent = *(--it);
+    return va < extent.getEnd() ? &extent : nullptr;
+  }
+
+  inline bool isMapped(addr_t va) const {
+    return find(va) != nullptr;
+  }
+
+  /**
+   * @brief Translate `va` with the index.
+   * 
+   * @param[in] va 
+   * @param[out] gpa 
+   * @return status_t `VMI_FAILURE` if `va` is not mapped (or out of range).
+   */
+  inline status_t translate(addr_t va, addr_t &gpa) const {
+    const Extent *extent = find(va);
+    if (!extent) return VMI_FAILURE;
+    gpa = (extent->gfn << PAGE_SHIFT) + (va - extent->va);
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Iterate over the extents in ascending order of virtual address.
+   * 
+   * @tparam F callback function type, `bool (const Extent &extent)`, return
+   * `true` to break.
+   * @param action 
+   */
+  template <typename F>
+  inline void forEachExtent(F action) const {
+    for (const Extent &extent : extents) {
+      if (action(extent)) break;
+    }
+  }
+
+  /**
+   * @brief Iterate over the mapped pages in ascending order.
+   * 
+   * @tparam F callback function type, `bool (addr_t pageNum, addr_t gfn)`,
+   * return `true` to break.
+   * @param action 
+   */
+  template <typename F>
+  inline void forEachMappedPage(F action) const {
+    for (const Extent &extent : extents) {
+      addr_t pageNum = glaToPageNum(extent.va);
+      for (addr_t i = 0; i < extent.pages; i++) {
+        if (action(pageNum + i, extent.gfn + i)) return;
+      }
+    }
+  }
+};
+
 
 }
 }
@@ -0,0 +1,516 @@
+/**
+ * @file scan.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Byte signature (pattern with wildcards) scanning of guest memory.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A6F2B83D_1C5E_4D97_B048_E3D7A9C15F60
+#define A6F2B83D_1C5E_4D97_B048_E3D7A9C15F60
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem.hh>
+#include <guestutil/mem/layout.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <vector>  // std::vector
+#include <string>  // std::string
+#include <mutex>  // std::lock_guard
+#include <exception>
+#include <algorithm>  // std::min
+#include <cstring>  // std::memcpy, std::memchr
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GUESTUTIL_SCAN_X86 1
+#endif
+
+
+namespace guestutil {
+namespace memory {
+
+
+class SignatureSyntaxError: public std::exception {
+public:
+  virtual const char *what() const throw() {
+    return "Invalid byte signature";
+  }
+};
+
+/**
+ * @brief A byte pattern with (per nibble) wildcards, e.g., a hook prologue
+ * `"e8 ?? ?? ?? ?? 4? 89"`.
+ * 
+ */
+class Signature {
+private:
+  std::vector<uint8_t> bytes;
+  /**
+   * @brief Bits that must match, `bytes` is already masked.
+   * 
+   */
+  std::vector<uint8_t> masks;
+  /**
+   * @brief Indices of the first and the last fully specified bytes, used to
+   * find candidates. Equal to `size()` if there is none.
+   * 
+   */
+  size_t first;
+  size_t last;
+
+  static inline int nibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  inline void index() {
+    first = last = bytes.size();
+    for (size_t i = 0; i < bytes.size(); i++) {
+      if (masks[i] != 0xff) continue;
+      if (first == bytes.size()) first = i;
+      last = i;
+    }
+  }
+public:
+  /**
+   * @brief Parse a signature of space-separated hex bytes, where `?` is a
+   * wildcard nibble (`??` or `?` alone for a whole byte).
+   * 
+   * @param signature
+   */
+  explicit Signature(const std::string &signature):
+    bytes(), masks(), first(0), last(0) {
+    for (size_t i = 0; i < signature.size();) {
+      if (signature[i] == ' ') {
+        i++;
+        continue;
+      }
+      size_t end = signature.find(' ', i);
+      if (end == std::string::npos) end = signature.size();
+      std::string token = signature.substr(i, end - i);
+      i = end;
+      if (token == "?") token = "??";
+      if (token.size() != 2) throw SignatureSyntaxError();
+      uint8_t byte = 0, mask = 0;
+      for (char c : token) {
+        byte <<= 4;
+        mask <<= 4;
+        if (c == '?') continue;
+        int val = nibble(c);
+        if (val < 0) throw SignatureSyntaxError();
+        byte |= val;
+        mask |= 0xf;
+      }
+      bytes.push_back(byte);
+      masks.push_back(mask);
+    }
+    if (bytes.empty()) throw SignatureSyntaxError();
+    index();
+  }
+
+  /**
+   * @brief Construct an exact (wildcard-free) signature.
+   * 
+   * @param data
+   * @param size
+   */
+  Signature(const void *data, size_t size):
+    bytes(
+      reinterpret_cast<const uint8_t *>(data),
+      reinterpret_cast<const uint8_t *>(data) + size
+    ), masks(size, 0xff), first(0), last(0) {
+    if (bytes.empty()) throw SignatureSyntaxError();
+    index();
+  }
+
+  inline size_t size() const {
+    return bytes.size();
+  }
+
+  /**
+   * @brief If `data` (at least `size()` bytes) matches this signature.
+   * 
+   * @param data
+   * @return bool
+   */
+  inline bool matches(const uint8_t *data) const {
+    for (size_t i = 0; i < bytes.size(); i++) {
+      if ((data[i] & masks[i]) != bytes[i]) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Find every match in `[data, data + size)`, in ascending order.
+   * Uses AVX2 or SSE2 when available.
+   * 
+   * @tparam F callback function type, `bool (size_t offset)`, return `true`
+   * to break.
+   * @param data
+   * @param size
+   * @param action
+   * @return bool if `action` broke the search.
+   */
+  template <typename F>
+  inline bool search(const uint8_t *data, size_t size, F action) const;
+
+  template <typename F>
+  inline bool searchScalar(const uint8_t *data, size_t size, F action) const;
+
+#ifdef GUESTUTIL_SCAN_X86
+  template <typename F>
+  __attribute__((target("sse2")))
+  inline bool searchSSE2(const uint8_t *data, size_t size, F action) const;
+
+  template <typename F>
+  __attribute__((target("avx2")))
+  inline bool searchAVX2(const uint8_t *data, size_t size, F action) const;
+#endif
+};
+
+template <typename F>
+inline bool Signature::searchScalar(
+  const uint8_t *data,
+  size_t size,
+  F action
+) const {
+  if (size < bytes.size()) return false;
+  size_t n = size - bytes.size() + 1;  // Candidate positions
+  if (first == bytes.size()) {  // Only wildcards
+    for (size_t pos = 0; pos < n; pos++) {
+      if (matches(data + pos) && action(pos)) return true;
+    }
+    return false;
+  }
+  for (size_t pos = 0; pos < n;) {
+    const void *hit = std::memchr(data + pos + first, bytes[first], n - pos);
+    if (!hit) break;
+    pos = reinterpret_cast<const uint8_t *>(hit) - data - first;
+    if (matches(data + pos) && action(pos)) return true;
+    pos++;
+  }
+  return false;
+}
+
+#ifdef GUESTUTIL_SCAN_X86
+
+/*
+ * The SIMD kernels compare the first and the last fully specified bytes of
+ * the signature at 16 or 32 candidate positions at once, and only verify the
+ * positions where both match. The tail is left to the scalar kernel.
+ */
+
+template <typename F>
+__attribute__((target("sse2")))
+inline bool Signature::searchSSE2(
+  const uint8_t *data,
+  size_t size,
+  F action
+) const {
+  if (size < bytes.size() || first == bytes.size()) {
+    return searchScalar(data, size, action);
+  }
+  size_t n = size - bytes.size() + 1;
+  const __m128i a = _mm_set1_epi8(char(bytes[first]));
+  const __m128i b = _mm_set1_epi8(char(bytes[last]));
+  size_t pos = 0;
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i x = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(data + pos + first));
+    __m128i y = _mm_loadu_si128(
+      reinterpret_cast<const __m128i *>(data + pos + last));
+    unsigned int mask = _mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(x, a), _mm_cmpeq_epi8(y, b)));
+    while (mask) {
+      size_t hit = pos + __builtin_ctz(mask);
+      if (matches(data + hit) && action(hit)) return true;
+      mask &= mask - 1;
+    }
+  }
+  return searchScalar(data + pos, size - pos, [pos, &action](size_t hit) {
+    return action(pos + hit);
+  });
+}
+
+template <typename F>
+__attribute__((target("avx2")))
+inline bool Signature::searchAVX2(
+  const uint8_t *data,
+  size_t size,
+  F action
+) const {
+  if (size < bytes.size() || first == bytes.size()) {
+    return searchScalar(data, size, action);
+  }
+  size_t n = size - bytes.size() + 1;
+  const __m256i a = _mm256_set1_epi8(char(bytes[first]));
+  const __m256i b = _mm256_set1_epi8(char(bytes[last]));
+  size_t pos = 0;
+  for (; pos + 32 <= n; pos += 32) {
+    __m256i x = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(data + pos + first));
+    __m256i y = _mm256_loadu_si256(
+      reinterpret_cast<const __m256i *>(data + pos + last));
+    unsigned int mask = _mm256_movemask_epi8(
+      _mm256_and_si256(_mm256_cmpeq_epi8(x, a), _mm256_cmpeq_epi8(y, b)));
+    while (mask) {
+      size_t hit = pos + __builtin_ctz(mask);
+      if (matches(data + hit) && action(hit)) return true;
+      mask &= mask - 1;
+    }
+  }
+  return searchScalar(data + pos, size - pos, [pos, &action](size_t hit) {
+    return action(pos + hit);
+  });
+}
+
+#endif
+
+template <typename F>
+inline bool Signature::search(
+  const uint8_t *data,
+  size_t size,
+  F action
+) const {
+#ifdef GUESTUTIL_SCAN_X86
+  static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+  static const bool hasSSE2 = __builtin_cpu_supports("sse2");
+  if (hasAVX2) return searchAVX2(data, size, action);
+  if (hasSSE2) return searchSSE2(data, size, action);
+#endif
+  return searchScalar(data, size, action);
+}
+
+/**
+ * @brief A match of a signature.
+ * 
+ */
+struct ScanHit {
+  /**
+   * @brief Virtual address of the match, 0 when scanning frames directly.
+   * 
+   */
+  addr_t va;
+  /**
+   * @brief Frame where the match starts.
+   * 
+   */
+  addr_t gfn;
+  /**
+   * @brief Offset of the match in frame `gfn`.
+   * 
+   */
+  addr_t offset;
+};
+
+namespace scanner {
+
+
+/**
+ * @brief Number of pages read from the guest at once.
+ * 
+ */
+constexpr addr_t chunkPages = 64;
+
+/**
+ * @brief Search a stream of physically contiguous runs for `sig`. The last
+ * `sig.size() - 1` bytes of a run are carried over to the next run if the
+ * two are virtually contiguous, so matches straddling pages are found.
+ * 
+ */
+class Stream {
+private:
+  const Signature &sig;
+  /**
+   * @brief If the runs are fed by frame (without virtual addresses).
+   * 
+   */
+  bool physical;
+  std::vector<uint8_t> buff;
+  /**
+   * @brief Carried bytes at the beginning of `buff`, and where they are (in a
+   * single page, since runs are page aligned).
+   * 
+   */
+  size_t carried;
+  addr_t carriedVA;
+  addr_t carriedGFN;
+  addr_t carriedOffset;
+  /**
+   * @brief VA (or GFN if `physical`) following the last run.
+   * 
+   */
+  addr_t next;
+public:
+  Stream(const Signature &_sig, bool _physical):
+    sig(_sig), physical(_physical), buff(), carried(0), carriedVA(0),
+    carriedGFN(0), carriedOffset(0), next(0) {};
+
+  /**
+   * @brief Search `pages` pages mapped at `va` (ignored if `physical`) to
+   * `gfn`.
+   * 
+   * @return bool if `action` broke the search.
+   */
+  template <typename F>
+  inline bool feed(
+    vmi_instance_t vmi,
+    addr_t va,
+    addr_t gfn,
+    addr_t pages,
+    F &action
+  ) {
+    constexpr addr_t pageMask = (addr_t(1) << PAGE_SHIFT) - 1;
+    if (physical) va = 0;
+    if ((physical ? gfn : va) != next) carried = 0;
+    size_t count = pages << PAGE_SHIFT;
+    buff.resize(carried + count);
+    size_t bytesRead = 0;
+    status_t status = VMI_FAILURE;
+    {
+      std::lock_guard<VMILock> guard(VMILock::of(vmi));
+      status = vmi_read_pa(
+        vmi, gfn << PAGE_SHIFT, count, buff.data() + carried, &bytesRead);
+    }
+    if (status == VMI_FAILURE || bytesRead != count) {
+      // Treat as unmapped
+      DBG() << "scan(): failed to read " << F_DEC(pages) << " page(s) at GFN "
+            << F_SHORT_HEX<addr_t>(gfn) << std::endl;
+      carried = 0;
+      next = 0;
+      return false;
+    }
+    if (sig.search(buff.data(), buff.size(),
+      [this, va, gfn, &action](size_t pos) {
+        if (pos < carried) {
+          return action(ScanHit{
+            carriedVA ? carriedVA + pos : 0, carriedGFN, carriedOffset + pos
+          });
+        }
+        pos -= carried;
+        return action(ScanHit{
+          va ? va + pos : 0, gfn + (pos >> PAGE_SHIFT), pos & pageMask
+        });
+      }
+    )) return true;
+    // Carry the tail over
+    size_t keep = std::min<size_t>(sig.size() - 1, count);
+    std::memmove(buff.data(), buff.data() + buff.size() - keep, keep);
+    carried = keep;
+    carriedVA = va ? va + count - keep : 0;
+    carriedGFN = gfn + pages - 1;
+    carriedOffset = ((pageMask + 1) - keep) & pageMask;
+    next = physical ? gfn + pages : va + count;
+    return false;
+  }
+};
+
+}
+
+/**
+ * @brief Search the mapped pages of `extents` for `sig` (which must not be
+ * larger than a page), including matches straddling virtually contiguous
+ * pages. Physically contiguous pages are read `scanner::chunkPages` at a
+ * time with `vmi_read_pa`.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * memory::Signature sig("0f 1f 44 00 00 55 48 89 e5");
+ * memory::scan(vmi, textRange, sig, [](const memory::ScanHit &hit) {
+ *   std::cout << F_HEX(hit.va) << std::endl;
+ *   return false;
+ * });
+ * ```
+ * 
+ * @tparam F callback function type, `bool (const ScanHit &hit)`, return
+ * `true` to break.
+ * @param vmi
+ * @param extents
+ * @param sig
+ * @param action
+ */
+template <typename F>
+inline void scan(
+  vmi_instance_t vmi,
+  const layout::MappedExtents &extents,
+  const Signature &sig,
+  F action
+) {
+  if (sig.size() > (addr_t(1) << PAGE_SHIFT)) throw SignatureSyntaxError();
+  scanner::Stream stream(sig, false);
+  extents.forEachExtent(
+    [vmi, &stream, &action](const layout::MappedExtents::Extent &extent) {
+      for (addr_t i = 0; i < extent.pages; i += scanner::chunkPages) {
+        addr_t pages = std::min(scanner::chunkPages, extent.pages - i);
+        if (stream.feed(
+          vmi, extent.va + (i << PAGE_SHIFT), extent.gfn + i, pages, action
+        )) return true;
+      }
+      return false;
+    });
+}
+
+/**
+ * @brief Search the mapped pages of `range` (kernel space only for now) for
+ * `sig` (see `scan`).
+ * 
+ * @tparam F
+ * @param vmi
+ * @param range
+ * @param sig
+ * @param action
+ */
+template <typename F>
+inline void scan(
+  vmi_instance_t vmi,
+  const layout::VirtRange &range,
+  const Signature &sig,
+  F action
+) {
+  scan(vmi, layout::MappedExtents(vmi, range), sig, action);
+}
+
+/**
+ * @brief Search the `nFrames` guest frames starting from `gfn` for `sig` (see
+ * `scan`). `ScanHit::va` is always 0, and matches straddling frames are
+ * found too.
+ * 
+ * @tparam F
+ * @param vmi
+ * @param gfn
+ * @param nFrames
+ * @param sig
+ * @param action
+ */
+template <typename F>
+inline void scanGFNs(
+  vmi_instance_t vmi,
+  addr_t gfn,
+  addr_t nFrames,
+  const Signature &sig,
+  F action
+) {
+  if (sig.size() > (addr_t(1) << PAGE_SHIFT)) throw SignatureSyntaxError();
+  scanner::Stream stream(sig, true);
+  for (addr_t i = 0; i < nFrames; i += scanner::chunkPages) {
+    addr_t pages = std::min(scanner::chunkPages, nFrames - i);
+    if (stream.feed(vmi, 0, gfn + i, pages, action)) return;
+  }
+}
+
+
+}
+}
+
+
+#endif /* A6F2B83D_1C5E_4D97_B048_E3D7A9C15F60 */
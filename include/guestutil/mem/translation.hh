@@ -15,9 +15,11 @@
 #include <libvmi/libvmi.h>
 
 #include <guestutil/mem.hh>
+#include <guestutil/mem/ReverseMap.hh>
 #include <debug.hh>
 
 #include <stdexcept>
+#include <vector>  // std::vector
 
 
 namespace guestutil {
@@ -89,6 +91,7 @@ class VirtAddr;
 class PhyAddr;
 class PageNum;
 class GFN;
+class Mapping;
 
 /**
  * @brief Guest virtual address.
@@ -99,8 +102,20 @@ public:
   using Addr::Addr;
 
   inline PhyAddr toPhyAddr(vmi_instance_t vmi);
+  inline status_t tryToPhyAddr(vmi_instance_t vmi, PhyAddr &phyAddr);
   inline PageNum toPageNum();
   inline GFN toGFN(vmi_instance_t vmi);
+  inline status_t tryToGFN(vmi_instance_t vmi, GFN &gfn);
+  inline Mapping toMapping(vmi_instance_t vmi);
+  /**
+   * @brief Same as `toMapping`, but return `VMI_FAILURE` instead of throwing
+   * if the address is not mapped.
+   * 
+   * @param[in] vmi 
+   * @param[out] mapping 
+   * @return status_t 
+   */
+  inline status_t tryToMapping(vmi_instance_t vmi, Mapping &mapping);
 };
 
 /**
@@ -112,6 +127,14 @@ public:
   using Addr::Addr;
 
   inline VirtAddr toVirtAddr();
+  /**
+   * @brief Get the lowest kernel virtual address mapping this address (see
+   * `ReverseMap`).
+   * 
+   * @param vmi 
+   * @return VirtAddr 
+   */
+  inline VirtAddr toVirtAddr(vmi_instance_t vmi);
   inline PageNum toPageNum();
   inline GFN toGFN();
 };
@@ -129,6 +152,15 @@ public:
   inline PhyAddr toPhyAddr(vmi_instance_t vmi);
   inline PhyAddr toPhyAddr(vmi_instance_t vmi, addr_t offset);
   inline GFN toGFN(vmi_instance_t vmi);
+  /**
+   * @brief Same as `toGFN`, but return `VMI_FAILURE` instead of throwing if
+   * the page is not mapped.
+   * 
+   * @param[in] vmi 
+   * @param[out] gfn 
+   * @return status_t 
+   */
+  inline status_t tryToGFN(vmi_instance_t vmi, GFN &gfn);
 
   inline friend
   std::ostream &operator<<(std::ostream &os, const PageNum &self) {
@@ -147,9 +179,36 @@ public:
 
   inline VirtAddr toVirtAddr();
   inline VirtAddr toVirtAddr(addr_t offset);
+  /**
+   * @brief Get the lowest kernel virtual address mapping this frame (see
+   * `ReverseMap`).
+   * 
+   * @param vmi 
+   * @return VirtAddr 
+   */
+  inline VirtAddr toVirtAddr(vmi_instance_t vmi);
+  inline VirtAddr toVirtAddr(vmi_instance_t vmi, addr_t offset);
+  /**
+   * @brief Same as `toVirtAddr(vmi)`, but return `VMI_FAILURE` instead of
+   * throwing if the frame is not mapped in kernel space.
+   * 
+   * @param[in] vmi 
+   * @param[out] virtAddr 
+   * @return status_t 
+   */
+  inline status_t tryToVirtAddr(vmi_instance_t vmi, VirtAddr &virtAddr);
+  /**
+   * @brief Get the kernel virtual addresses of all the pages mapping this
+   * frame, in ascending order (see `ReverseMap`).
+   * 
+   * @param vmi 
+   * @return std::vector<addr_t> 
+   */
+  inline std::vector<addr_t> getVirtAddrs(vmi_instance_t vmi);
   inline PhyAddr toPhyAddr();
   inline PhyAddr toPhyAddr(addr_t offset);
   inline PageNum toPageNum();
+  inline PageNum toPageNum(vmi_instance_t vmi);
 
   inline friend
   std::ostream &operator<<(std::ostream &os, const GFN &self) {
@@ -158,11 +217,84 @@ public:
   }
 };
 
+/**
+ * @brief A leaf mapping of virtual memory, i.e., a 4 KiB, 2 MiB or 1 GiB page
+ * (x86-64 specific), mapped to physically contiguous memory.
+ * 
+ */
+class Mapping {
+private:
+  addr_t va;
+  addr_t pa;
+  addr_t size;
+public:
+  Mapping(): va(0), pa(0), size(0) {};
+  Mapping(addr_t _va, addr_t _pa, addr_t _size):
+    va(_va), pa(_pa), size(_size) {};
+
+  /**
+   * @brief Get the first virtual address of this mapping.
+   * 
+   * @return VirtAddr 
+   */
+  inline VirtAddr getVirtAddr() const {
+    return VirtAddr(va);
+  }
+
+  /**
+   * @brief Get the physical address `getVirtAddr()` is mapped to.
+   * 
+   * @return PhyAddr 
+   */
+  inline PhyAddr getPhyAddr() const {
+    return PhyAddr(pa);
+  }
+
+  inline addr_t getSize() const {
+    return size;
+  }
+
+  /**
+   * @brief Get the number of 4 KiB pages in this mapping.
+   * 
+   * @return addr_t 
+   */
+  inline addr_t getPages() const {
+    return size >> PAGE_SHIFT;
+  }
+
+  /**
+   * @brief If this is a 2 MiB or 1 GiB mapping.
+   * 
+   * @return bool 
+   */
+  inline bool isHuge() const {
+    return size > (addr_t(1) << PAGE_SHIFT);
+  }
+
+  inline PageNum getStartPageNum() const;
+  inline GFN getStartGFN() const;
+
+  inline friend
+  std::ostream &operator<<(std::ostream &os, const Mapping &self) {
+    os << F_HEX<addr_t>(self.va) << ':' << F_SHORT_HEX<addr_t>(self.size)
+       << " => " << F_HEX<addr_t>(self.pa);
+    return os;
+  }
+};
+
 
 inline PhyAddr VirtAddr::toPhyAddr(vmi_instance_t vmi) {
   return PhyAddr(kvaToGPA(vmi, addr));
 }
 
+inline status_t VirtAddr::tryToPhyAddr(vmi_instance_t vmi, PhyAddr &phyAddr) {
+  addr_t gpa = 0;
+  if (tryKvaToGPA(vmi, addr, gpa) == VMI_FAILURE) return VMI_FAILURE;
+  phyAddr = PhyAddr(gpa);
+  return VMI_SUCCESS;
+}
+
 inline PageNum VirtAddr::toPageNum() {
   return PageNum(glaToPageNum(addr));
 }
@@ -171,10 +303,36 @@ inline GFN VirtAddr::toGFN(vmi_instance_t vmi) {
   return toPhyAddr(vmi).toGFN();
 }
 
+inline status_t VirtAddr::tryToGFN(vmi_instance_t vmi, GFN &gfn) {
+  addr_t gfnVal = 0;
+  if (tryKvaToGFN(vmi, addr, gfnVal) == VMI_FAILURE) return VMI_FAILURE;
+  gfn = GFN(gfnVal);
+  return VMI_SUCCESS;
+}
+
+inline Mapping VirtAddr::toMapping(vmi_instance_t vmi) {
+  Mapping mapping;
+  if (tryToMapping(vmi, mapping) == VMI_FAILURE) {
+    throw MemoryTranslationError(KVA_TO_GPA, addr, nullptr);
+  }
+  return mapping;
+}
+
+inline status_t VirtAddr::tryToMapping(vmi_instance_t vmi, Mapping &mapping) {
+  addr_t gpa = 0, size = 0;
+  if (tryKvaToGPA(vmi, addr, gpa, size) == VMI_FAILURE) return VMI_FAILURE;
+  mapping = Mapping(addr & ~(size - 1), gpa & ~(size - 1), size);
+  return VMI_SUCCESS;
+}
+
 inline VirtAddr PhyAddr::toVirtAddr() {
   throw std::runtime_error("Not implemented");
 }
 
+inline VirtAddr PhyAddr::toVirtAddr(vmi_instance_t vmi) {
+  return toGFN().toVirtAddr(vmi, addr & ((addr_t(1) << PAGE_SHIFT) - 1));
+}
+
 inline GFN PhyAddr::toGFN() {
   return GFN(gpaToGFN(addr));
 }
@@ -199,6 +357,10 @@ inline GFN PageNum::toGFN(vmi_instance_t vmi) {
   return toVirtAddr().toPhyAddr(vmi).toGFN();
 }
 
+inline status_t PageNum::tryToGFN(vmi_instance_t vmi, GFN &gfn) {
+  return toVirtAddr().tryToGFN(vmi, gfn);
+}
+
 inline VirtAddr GFN::toVirtAddr() {
   throw std::runtime_error("Not implemented");
 }
@@ -207,8 +369,33 @@ inline VirtAddr GFN::toVirtAddr(addr_t offset) {
   return toVirtAddr() + offset;
 }
 
+inline VirtAddr GFN::toVirtAddr(vmi_instance_t vmi) {
+  VirtAddr virtAddr(0);
+  if (tryToVirtAddr(vmi, virtAddr) == VMI_FAILURE) {
+    throw MemoryTranslationError(GFN_TO_KVA, addr << PAGE_SHIFT, nullptr);
+  }
+  return virtAddr;
+}
+
+inline VirtAddr GFN::toVirtAddr(vmi_instance_t vmi, addr_t offset) {
+  return toVirtAddr(vmi) + offset;
+}
+
+inline status_t GFN::tryToVirtAddr(vmi_instance_t vmi, VirtAddr &virtAddr) {
+  addr_t va = 0;
+  if (ReverseMap::of(vmi).tryGetVA(addr, va) == VMI_FAILURE) {
+    return VMI_FAILURE;
+  }
+  virtAddr = VirtAddr(va);
+  return VMI_SUCCESS;
+}
+
+inline std::vector<addr_t> GFN::getVirtAddrs(vmi_instance_t vmi) {
+  return ReverseMap::of(vmi).getVAs(addr);
+}
+
 inline PhyAddr GFN::toPhyAddr() {
-  return PhyAddr(addr >> PAGE_SHIFT);
+  return PhyAddr(addr << PAGE_SHIFT);
 }
 
 inline PhyAddr GFN::toPhyAddr(addr_t offset) {
@@ -219,6 +406,18 @@ inline PageNum GFN::toPageNum() {
   throw std::runtime_error("Not implemented");
 }
 
+inline PageNum GFN::toPageNum(vmi_instance_t vmi) {
+  return toVirtAddr(vmi).toPageNum();
+}
+
+inline PageNum Mapping::getStartPageNum() const {
+  return getVirtAddr().toPageNum();
+}
+
+inline GFN Mapping::getStartGFN() const {
+  return getPhyAddr().toGFN();
+}
+
 
 }
 }
@@ -19,6 +19,9 @@ public:
 /**
  * @brief Get the memory offset associated with the given offset_name.
  * 
+ * This is a string-keyed lookup in LibVMI; for the offsets known to
+ * `OffsetTable`, use `OffsetTable::of(vmi).get<key>()` instead.
+ * 
  * @param vmi 
  * @param offsetName 
  * @return addr_t 
@@ -0,0 +1,341 @@
+/**
+ * @file OffsetTable.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Offsets resolved once into a table indexed by `OffsetKey`.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef E2A7C9F4_18B3_4D6E_9F51_7C0B3A8D2E64
+#define E2A7C9F4_18B3_4D6E_9F51_7C0B3A8D2E64
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/offset.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <memory>  // std::unique_ptr
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <fstream>  // std::ifstream, std::ofstream
+#include <algorithm>  // std::min
+#include <exception>
+#include <cstdlib>  // std::strtoull
+#include <cstdint>
+
+
+namespace guestutil {
+namespace offset {
+
+
+/**
+ * @brief Offsets known to `OffsetTable`, named after the keys of
+ * `vmi_get_offset` (see `offsetNames`).
+ * 
+ */
+enum OffsetKey {
+  /**
+   * @brief `task_struct.tasks`.
+   * 
+   */
+  LINUX_TASKS,
+  /**
+   * @brief `task_struct.mm`.
+   * 
+   */
+  LINUX_MM,
+  /**
+   * @brief `task_struct.pid`.
+   * 
+   */
+  LINUX_PID,
+  /**
+   * @brief `task_struct.comm`.
+   * 
+   */
+  LINUX_NAME,
+  /**
+   * @brief `mm_struct.pgd`.
+   * 
+   */
+  LINUX_PGD,
+  /**
+   * @brief `task_struct.real_parent` (not provided by LibVMI, set it with a
+   * profile, see `OffsetTable::fromFile`).
+   * 
+   */
+  LINUX_REAL_PARENT,
+  /**
+   * @brief Kernel page directory (a physical address, not an offset, and
+   * only valid for the current boot).
+   * 
+   */
+  KPGD,
+  N_OFFSET_KEYS
+};
+
+constexpr const char *offsetNames[N_OFFSET_KEYS] = {
+  "linux_tasks",
+  "linux_mm",
+  "linux_pid",
+  "linux_name",
+  "linux_pgd",
+  "linux_real_parent",
+  "kpgd"
+};
+
+class OffsetProfileError: public std::exception {
+public:
+  std::string path;
+  size_t line;
+  std::string msg;
+  OffsetProfileError(const std::string &_path, size_t _line):
+    path(_path), line(_line) {
+    msg = "Malformed offset profile " + path;
+    if (line) msg += " at line " + std::to_string(line);
+  };
+  const char *what() const throw() {
+    return msg.c_str();
+  }
+};
+
+/**
+ * @brief All the offsets of `OffsetKey`, resolved once (from LibVMI or from a
+ * profile file) so that hot code indexes a fixed array instead of doing
+ * string-keyed lookups with `vmi_get_offset`.
+ * 
+ * `OffsetTable::of(vmi)` is resolved from LibVMI when `vm::VM` attaches. A
+ * profile file (see `fromFile`) has one `name = value` per line, same as the
+ * entries of a LibVMI config (e.g., `linux_tasks = 0x4c8;`), and can be
+ * written with `save`.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * using offset::OffsetTable;
+ * OffsetTable::use(vmi, OffsetTable::fromFile("debian11.offsets"));
+ * addr_t pidOffset = offset::OffsetTable::of(vmi).get<offset::LINUX_PID>();
+ * ```
+ * 
+ */
+class OffsetTable {
+private:
+  addr_t values[N_OFFSET_KEYS];
+  /**
+   * @brief Bit `key` is set if `values[key]` is known.
+   * 
+   */
+  uint32_t known;
+
+  static_assert(N_OFFSET_KEYS <= 32, "Too many offset keys");
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<OffsetTable>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` offset tables.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<OffsetTable>>
+      tables;
+    return tables;
+  }
+
+  static inline bool parseKey(std::string_view name, OffsetKey &key) {
+    for (unsigned int i = 0; i < N_OFFSET_KEYS; i++) {
+      if (name == offsetNames[i]) {
+        key = OffsetKey(i);
+        return true;
+      }
+    }
+    return false;
+  }
+public:
+  OffsetTable(): values(), known(0) {};
+
+  /**
+   * @brief Resolve every offset of `OffsetKey` with `vmi_get_offset`. The ones
+   * LibVMI does not know are left unknown.
+   * 
+   * @param vmi
+   * @return OffsetTable
+   */
+  static OffsetTable fromVMI(vmi_instance_t vmi) {
+    OffsetTable table;
+    for (unsigned int i = 0; i < N_OFFSET_KEYS; i++) {
+      addr_t value = 0;
+      if (vmi_get_offset(vmi, offsetNames[i], &value) == VMI_SUCCESS) {
+        table.set(OffsetKey(i), value);
+      }
+    }
+    DBG() << "OffsetTable::fromVMI(): " << F_DEC(table.size()) << '/'
+          << F_DEC(N_OFFSET_KEYS) << " offset(s)" << std::endl;
+    return table;
+  }
+
+  /**
+   * @brief Load offsets from the profile file at `path`. Blank lines, `#`
+   * and `//` comments, and unknown names are skipped.
+   * 
+   * @param path
+   * @return OffsetTable
+   */
+  static OffsetTable fromFile(const char *path) {
+    std::ifstream file(path);
+    if (!file) throw OffsetProfileError(path, 0);
+    OffsetTable table;
+    std::string line;
+    for (size_t lineNo = 1; std::getline(file, line); lineNo++) {
+      std::string_view rest(line);
+      size_t comment = std::min(rest.find('#'), rest.find("//"));
+      if (comment != std::string_view::npos) rest = rest.substr(0, comment);
+      size_t first = rest.find_first_not_of(" \t\r");
+      if (first == std::string_view::npos) continue;  // Blank
+      rest = rest.substr(first);
+      size_t eq = rest.find('=');
+      if (eq == std::string_view::npos) throw OffsetProfileError(path, lineNo);
+      std::string_view name = rest.substr(0, eq);
+      name = name.substr(0, name.find_last_not_of(" \t") + 1);
+      std::string valueStr(rest.substr(eq + 1));
+      const char *begin = valueStr.c_str();
+      char *end = nullptr;
+      addr_t value = std::strtoull(begin, &end, 0);
+      if (end == begin) throw OffsetProfileError(path, lineNo);
+      OffsetKey key;
+      if (!parseKey(name, key)) {
+        DBG() << "OffsetTable::fromFile(): unknown offset " << name
+              << std::endl;
+        continue;
+      }
+      table.set(key, value);
+    }
+    DBG() << "OffsetTable::fromFile(): " << F_DEC(table.size()) << '/'
+          << F_DEC(N_OFFSET_KEYS) << " offset(s) from " << path << std::endl;
+    return table;
+  }
+
+  /**
+   * @brief Get the offset table of `vmi`, resolved from LibVMI on first use
+   * (normally when `vm::VM` attaches).
+   * 
+   * @param vmi
+   * @return OffsetTable&
+   */
+  static OffsetTable &of(vmi_instance_t vmi) {
+    auto &tables = registry();
+    auto it = tables.find(vmi);
+    if (it == tables.end()) {
+      it = tables.emplace(
+        vmi, std::unique_ptr<OffsetTable>(new OffsetTable(fromVMI(vmi)))
+      ).first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Use the known offsets of `table` for `vmi` (e.g., loaded with
+   * `fromFile`), overriding those resolved from LibVMI. Offsets unknown to
+   * `table` are kept, and `KPGD` (never in a profile) is always resolved
+   * from LibVMI.
+   * 
+   * @param vmi
+   * @param table
+   * @return OffsetTable& the offset table of `vmi`.
+   */
+  static OffsetTable &use(vmi_instance_t vmi, const OffsetTable &table) {
+    auto &tables = registry();
+    auto it = tables.find(vmi);
+    if (it == tables.end()) {
+      it = tables.emplace(
+        vmi, std::unique_ptr<OffsetTable>(new OffsetTable())).first;
+      addr_t kpgd = 0;
+      if (vmi_get_offset(vmi, offsetNames[KPGD], &kpgd) == VMI_SUCCESS) {
+        it->second->set(KPGD, kpgd);
+      }
+    }
+    OffsetTable &current = *it->second;
+    for (unsigned int i = 0; i < N_OFFSET_KEYS; i++) {
+      if (table.has(OffsetKey(i))) current.set(OffsetKey(i), table.values[i]);
+    }
+    return current;
+  }
+
+  /**
+   * @brief Free the offset table of `vmi` (if any). Called before `vmi` is
+   * destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  /**
+   * @brief Write the known offsets (except `KPGD`) to a profile file at
+   * `path` (see `fromFile`).
+   * 
+   * @param path
+   * @return bool if written.
+   */
+  inline bool save(const char *path) const {
+    std::ofstream file(path);
+    if (!file) return false;
+    for (unsigned int i = 0; i < N_OFFSET_KEYS; i++) {
+      if (i == KPGD || !has(OffsetKey(i))) continue;
+      file << offsetNames[i] << " = " << F_SHORT_UH64(values[i]) << ';'
+           << std::endl;
+    }
+    return bool(file);
+  }
+
+  inline void set(OffsetKey key, addr_t value) {
+    values[key] = value;
+    known |= uint32_t(1) << key;
+  }
+
+  inline bool has(OffsetKey key) const {
+    return known & (uint32_t(1) << key);
+  }
+
+  /**
+   * @brief Get the number of known offsets.
+   * 
+   * @return size_t
+   */
+  inline size_t size() const {
+    return __builtin_popcount(known);
+  }
+
+  inline status_t tryGet(OffsetKey key, addr_t &value) const {
+    if (!has(key)) return VMI_FAILURE;
+    value = values[key];
+    return VMI_SUCCESS;
+  }
+
+  inline addr_t get(OffsetKey key) const {
+    if (!has(key)) throw GetOffsetError();
+    return values[key];
+  }
+
+  /**
+   * @brief Get the offset `key`, checked at compile time.
+   * 
+   * @tparam key
+   * @return addr_t
+   */
+  template <OffsetKey key>
+  inline addr_t get() const {
+    static_assert(key < N_OFFSET_KEYS, "Invalid offset key");
+    return get(key);
+  }
+};
+
+
+}
+}
+
+
+#endif /* E2A7C9F4_18B3_4D6E_9F51_7C0B3A8D2E64 */
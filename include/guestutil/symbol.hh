@@ -3,6 +3,12 @@
 
 #include <libvmi/libvmi.h>
 #include <exception>
+#include <guestutil/symbol/SymbolCache.hh>
+#include <guestutil/symbol/SymbolDB.hh>
+#include <guestutil/symbol/SymbolIndex.hh>
+#include <guestutil/offset/OffsetTable.hh>
+#include <memory>
+#include <string>
 
 
 namespace guestutil {
@@ -16,14 +22,44 @@ public:
   }
 };
 
+/**
+ * @brief Translate kernel symbol `symbol` to its address (cached, see
+ * `SymbolCache`).
+ * 
+ * @param vmi 
+ * @param symbol 
+ * @return addr_t 
+ */
 inline addr_t translateKernelSymbol(vmi_instance_t vmi, const char *symbol) {
   addr_t addr;
-  if (vmi_translate_ksym2v(vmi, symbol, &addr) == VMI_FAILURE) {
+  if (SymbolCache::of(vmi).tryTranslate(symbol, addr) == VMI_FAILURE) {
     throw SymbolTranslationError();
   }
   return addr;
 }
 
+/**
+ * @brief Resolve the kernel symbols and offsets of `vmi` with the symbol
+ * database at `path` (see `SymbolDB`) from now on, instead of the System.map
+ * and the offsets of the LibVMI config.
+ * 
+ * @param vmi 
+ * @param path 
+ * @return std::shared_ptr<const SymbolDB> the database.
+ * @throw KASLRShiftError if the KASLR shift cannot be found.
+ */
+inline std::shared_ptr<const SymbolDB> useSymbolDB(
+  vmi_instance_t vmi,
+  const std::string &path
+) {
+  auto db = std::make_shared<const SymbolDB>(path);
+  SymbolCache::of(vmi).useDB(db);
+  // An index built before would keep the old symbols
+  SymbolIndex::drop(vmi);
+  offset::OffsetTable::use(vmi, db->getOffsets());
+  return db;
+}
+
 
 }
 }
@@ -0,0 +1,335 @@
+/**
+ * @file SymbolCache.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Per-VMI cache of kernel symbol addresses.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef A3C8E1F7_5B26_4D94_8F0A_6E2D9B4C7A15
+#define A3C8E1F7_5B26_4D94_8F0A_6E2D9B4C7A15
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/symbol/sysmap.hh>
+#include <guestutil/symbol/SymbolDB.hh>
+#include <guestutil/VMILock.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <deque>  // std::deque
+#include <memory>  // std::unique_ptr, std::shared_ptr
+#include <mutex>  // std::lock_guard
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <exception>  // std::exception
+
+
+namespace guestutil {
+namespace symbol {
+
+
+class KASLRShiftError: public std::exception {
+public:
+  virtual const char *what() const throw() {
+    return "Failed to find the KASLR shift";
+  }
+};
+
+/**
+ * @brief Per `vmi_instance_t` cache of kernel symbol addresses, shared by
+ * `symbol::translateKernelSymbol` and `memory::ksymToKVA`.
+ * 
+ * Symbols are resolved with `vmi_translate_ksym2v` on first use and cached
+ * (including failures). Alternatively, `preload` loads the whole System.map
+ * of the guest once, or `useDB` attaches a precompiled `SymbolDB`, after
+ * which lookups never call into LibVMI. Symbol names
+ * are interned, i.e., stored once and keyed by `std::string_view`, so lookups
+ * by `const char *` or `std::string_view` do not allocate.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * symbol::SymbolCache::of(vmi).preload();  // Optional
+ * addr_t initTask = symbol::translateKernelSymbol(vmi, "init_task");
+ * ```
+ * 
+ */
+class SymbolCache {
+private:
+  struct Entry {
+    addr_t addr;
+    /**
+     * @brief `false` for a failed lookup (`addr` is meaningless then).
+     * 
+     */
+    bool found;
+  };
+
+  vmi_instance_t vmi;
+  /**
+   * @brief Interned symbol names (references stay valid on `push_back`).
+   * 
+   */
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, Entry> addrs;
+  /**
+   * @brief If the whole symbol table is loaded (and the KASLR shift is
+   * known), then symbols not found are not looked up with LibVMI.
+   * 
+   */
+  bool complete;
+  /**
+   * @brief KASLR shift found by `preload` or `useDB`.
+   * 
+   */
+  addr_t shift;
+  std::shared_ptr<const SymbolDB> db;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<SymbolCache>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` symbol caches.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<SymbolCache>>
+      caches;
+    return caches;
+  }
+
+  SymbolCache(vmi_instance_t _vmi):
+    vmi(_vmi), names(), addrs(), complete(false), shift(0), db() {};
+
+  SymbolCache(SymbolCache&) = delete;
+  SymbolCache(SymbolCache&&) = delete;
+
+  inline std::string_view intern(std::string_view name) {
+    names.emplace_back(name);
+    return names.back();
+  }
+
+public:
+  /**
+   * @brief Get the symbol cache of `vmi` (created on first use).
+   * 
+   * @param vmi
+   * @return SymbolCache&
+   */
+  static SymbolCache &of(vmi_instance_t vmi) {
+    auto &caches = registry();
+    auto it = caches.find(vmi);
+    if (it == caches.end()) {
+      it = caches.emplace(
+        vmi, std::unique_ptr<SymbolCache>(new SymbolCache(vmi))).first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the symbol cache of `vmi` (if any). Called before `vmi` is
+   * destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  /**
+   * @brief Load the whole System.map at `path` (that of `vmi` if `nullptr`).
+   * 
+   * The KASLR shift is found by resolving one symbol (`_text`, or else
+   * `init_task`) with LibVMI and comparing with its System.map address (see
+   * `tryFindShift`). If it cannot be found, nothing is loaded. Absolute
+   * symbols are skipped.
+   * 
+   * @param path
+   * @return size_t the number of symbols loaded, 0 if the System.map cannot
+   * be read or the KASLR shift is unknown (symbols are still resolved lazily
+   * then).
+   */
+  inline size_t preload(const char *path = nullptr) {
+    if (!path) path = vmi_get_linux_sysmap(vmi);
+    if (!path) {
+      DBG() << "SymbolCache.preload(): no System.map" << std::endl;
+      return 0;
+    }
+    std::string content;
+    if (!readSymbolFile(path, content)) {
+      DBG() << "SymbolCache.preload(): failed to open " << path << std::endl;
+      return 0;
+    }
+    // Parse unshifted first, then shift by the KASLR offset
+    std::unordered_map<std::string_view, addr_t> raw;
+    forEachSymbolLine(content, [&raw](
+      addr_t addr, char type, std::string_view name, std::string_view
+    ) {
+      // Keep the first one of duplicated (local) names
+      if (!isAbsoluteSymbol(type)) raw.emplace(name, addr);
+    });
+    addr_t delta = 0;
+    if (tryFindShift([&raw](const char *probe, addr_t &addr) {
+      auto it = raw.find(probe);
+      if (it == raw.end()) return false;
+      addr = it->second;
+      return true;
+    }, delta) == VMI_FAILURE) {
+      DBG() << "SymbolCache.preload(): unknown KASLR shift, " << path
+            << " not loaded" << std::endl;
+      return 0;
+    }
+    for (auto &entry : raw) {
+      addr_t addr = entry.second;
+      if (isShiftedByKASLR(addr)) addr += delta;
+      // Keep what was resolved by LibVMI before
+      auto it = addrs.find(entry.first);
+      if (it == addrs.end()) {
+        addrs.emplace(intern(entry.first), Entry{addr, true});
+      } else if (!it->second.found) {
+        it->second = Entry{addr, true};
+      }
+    }
+    complete = true;
+    shift = delta;
+    DBG() << "SymbolCache.preload(): " << F_DEC(raw.size())
+          << " symbol(s) from " << path << ", KASLR shift "
+          << F_HEX<addr_t>(delta) << std::endl;
+    return raw.size();
+  }
+
+  /**
+   * @brief Resolve symbols with `_db` from now on (see `SymbolDB`), so that
+   * nothing is parsed nor looked up with LibVMI, except the probe symbol for
+   * the KASLR shift.
+   * 
+   * @param _db
+   * @throw KASLRShiftError if the KASLR shift cannot be found (see
+   * `tryFindShift`), the cache is left unchanged then.
+   */
+  inline void useDB(std::shared_ptr<const SymbolDB> _db) {
+    addr_t delta = 0;
+    if (tryFindShift([&_db](const char *probe, addr_t &raw) {
+      return _db->tryFind(probe, raw) == VMI_SUCCESS;
+    }, delta) == VMI_FAILURE) {
+      throw KASLRShiftError();
+    }
+    db = std::move(_db);
+    addrs.clear();
+    names.clear();
+    shift = delta;
+    complete = true;
+    DBG() << "SymbolCache.useDB(): " << db->getPath() << ", KASLR shift "
+          << F_HEX<addr_t>(shift) << std::endl;
+  }
+
+  /**
+   * @brief Get the attached `SymbolDB` (see `useDB`).
+   * 
+   * @return std::shared_ptr<const SymbolDB> `nullptr` if none.
+   */
+  inline std::shared_ptr<const SymbolDB> getDB() const {
+    return db;
+  }
+
+  inline bool isComplete() const {
+    return complete;
+  }
+
+  /**
+   * @brief Get the KASLR shift of the kernel relative to its System.map
+   * (valid if `isComplete`, i.e., after `preload` or `useDB` succeeded).
+   * 
+   * @return addr_t 
+   */
+  inline addr_t getShift() const {
+    return shift;
+  }
+
+  /**
+   * @brief Find the KASLR shift by resolving a probe symbol (`_text`, or else
+   * `init_task`) with LibVMI, and comparing with its unshifted address
+   * `rawAddrOf(name, addr)`. Nothing is parsed nor cached.
+   * 
+   * @tparam F callback function type,
+   * `bool (const char *name, addr_t &addr)`, return `false` if unknown.
+   * @param[in] rawAddrOf
+   * @param[out] shift 0 without KASLR.
+   * @return status_t `VMI_FAILURE` if no probe symbol can be resolved (the
+   * shift is unknown, NOT 0).
+   */
+  template <typename F>
+  inline status_t tryFindShift(F &&rawAddrOf, addr_t &shift) {
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    for (const char *probe : {"_text", "init_task"}) {
+      addr_t raw = 0;
+      addr_t addr = 0;
+      if (
+        rawAddrOf(probe, raw) &&
+        vmi_translate_ksym2v(vmi, probe, &addr) == VMI_SUCCESS
+      ) {
+        shift = addr - raw;
+        return VMI_SUCCESS;
+      }
+    }
+    return VMI_FAILURE;
+  }
+
+  inline size_t size() const {
+    return addrs.size();
+  }
+
+  /**
+   * @brief Translate kernel symbol `symbol` to its address.
+   * 
+   * @param[in] symbol
+   * @param[out] addr
+   * @return status_t
+   */
+  inline status_t tryTranslate(std::string_view symbol, addr_t &addr) {
+    auto it = addrs.find(symbol);
+    if (it != addrs.end()) {
+      addr = it->second.addr;
+      return it->second.found ? VMI_SUCCESS : VMI_FAILURE;
+    }
+    if (db) {
+      // One probe of the mapped hash table, nothing to cache
+      std::string_view module;
+      if (db->tryFind(symbol, addr, module) == VMI_FAILURE) return VMI_FAILURE;
+      // Module symbols (from kallsyms) are not affected by the KASLR shift
+      if (module.empty() && isShiftedByKASLR(addr)) addr += shift;
+      return VMI_SUCCESS;
+    }
+    if (complete) return VMI_FAILURE;
+    std::string_view name = intern(symbol);
+    std::lock_guard<VMILock> guard(VMILock::of(vmi));
+    if (vmi_translate_ksym2v(vmi, name.data(), &addr) == VMI_FAILURE) {
+      addrs.emplace(name, Entry{0, false});
+      return VMI_FAILURE;
+    }
+    addrs.emplace(name, Entry{addr, true});
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Forget everything (e.g., the guest rebooted with a different
+   * KASLR offset).
+   * 
+   */
+  inline void clear() {
+    addrs.clear();
+    names.clear();
+    complete = false;
+    shift = 0;
+    db.reset();
+  }
+};
+
+
+}
+}
+
+
+#endif /* A3C8E1F7_5B26_4D94_8F0A_6E2D9B4C7A15 */
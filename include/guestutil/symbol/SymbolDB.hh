@@ -0,0 +1,542 @@
+/**
+ * @file SymbolDB.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Precompiled, memory-mapped database of kernel symbols and offsets.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef F3B8D1E6_7A24_4C59_8E0F_2D6A9C4B7E31
+#define F3B8D1E6_7A24_4C59_8E0F_2D6A9C4B7E31
+
+
+#include <libvmi/libvmi.h>
+#include <fcntl.h>  // open, O_*
+#include <unistd.h>  // close
+#include <sys/mman.h>  // mmap, munmap
+#include <sys/stat.h>  // fstat
+
+#include <guestutil/symbol/sysmap.hh>
+#include <guestutil/offset/OffsetTable.hh>
+#include <debug.hh>
+
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <vector>  // std::vector
+#include <fstream>  // std::ofstream
+#include <algorithm>  // std::stable_sort
+#include <exception>
+#include <cerrno>  // errno
+#include <cstring>  // std::memcmp, std::memcpy, std::strerror
+#include <cstdint>
+
+
+namespace guestutil {
+namespace symbol {
+
+
+namespace db {
+
+
+/**
+ * @brief The symbol database file format (all integers in host byte order).
+ * 
+ * ```
+ * +----------------------+ 0
+ * | Header               |
+ * +----------------------+ addrsOffset
+ * | Addresses            | nSymbols * uint64_t, sorted
+ * +----------------------+ infosOffset
+ * | Symbol infos         | nSymbols * SymbolInfo, same order
+ * +----------------------+ hashOffset
+ * | Name hash table      | hashSize * uint32_t, symbol index + 1 (0: empty)
+ * +----------------------+ offsetsOffset
+ * | Offsets              | nOffsets * OffsetEntry
+ * +----------------------+ stringsOffset
+ * | Strings              | stringsSize bytes, NUL-terminated
+ * +----------------------+
+ * ```
+ * 
+ * Addresses are as in the System.map, i.e., without the KASLR shift. Every
+ * section is 8-byte aligned so that it is used in place once mapped, and
+ * nothing is parsed when the file is opened.
+ * 
+ */
+constexpr char magic[8] = {'B', 'V', 'M', 'I', 'S', 'Y', 'M', '\0'};
+constexpr uint32_t version = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t nSymbols;
+  /**
+   * @brief Number of slots of the name hash table (a power of 2).
+   * 
+   */
+  uint64_t hashSize;
+  uint64_t nOffsets;
+  uint64_t stringsSize;
+  uint64_t addrsOffset;
+  uint64_t infosOffset;
+  uint64_t hashOffset;
+  uint64_t offsetsOffset;
+  uint64_t stringsOffset;
+};
+
+struct SymbolInfo {
+  /**
+   * @brief Offsets of the name and module (0: the kernel itself) in the
+   * strings.
+   * 
+   */
+  uint32_t name;
+  uint32_t module;
+  /**
+   * @brief System.map symbol type, e.g., `T`.
+   * 
+   */
+  char type;
+  uint8_t reserved[3];
+};
+
+/**
+ * @brief An offset (see `offset::OffsetTable`), keyed by its name so that
+ * files stay valid when `offset::OffsetKey` changes.
+ * 
+ */
+struct OffsetEntry {
+  uint32_t name;
+  uint32_t reserved;
+  uint64_t value;
+};
+
+/**
+ * @brief 64-bit FNV-1a hash of a symbol name.
+ * 
+ */
+inline uint64_t hashName(std::string_view name) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (char c : name) {
+    h ^= uint8_t(c);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+inline uint64_t align8(uint64_t n) {
+  return (n + 7) & ~uint64_t(7);
+}
+
+
+}
+
+class SymbolDBError: public std::exception {
+private:
+  std::string msg;
+public:
+  SymbolDBError(const std::string &_msg): msg(_msg) {};
+
+  virtual const char *what() const throw() {
+    return msg.c_str();
+  }
+};
+
+/**
+ * @brief Compile kernel symbols and offsets into a symbol database file (see
+ * `SymbolDB`).
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * symbol::SymbolDBBuilder builder;
+ * builder.loadSymbols("System.map");
+ * builder.setOffsets(offset::OffsetTable::fromFile("debian11.offsets"));
+ * builder.write("debian11.symdb");
+ * ```
+ * 
+ */
+class SymbolDBBuilder {
+private:
+  struct Symbol {
+    addr_t addr;
+    uint32_t name;
+    uint32_t module;
+    char type;
+  };
+
+  std::string strings;
+  std::vector<Symbol> symbols;
+  std::vector<db::OffsetEntry> offsets;
+  /**
+   * @brief Last module stored (symbols of a module come in a row).
+   * 
+   */
+  uint32_t lastModule;
+
+  inline uint32_t store(std::string_view str) {
+    uint32_t offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+  }
+public:
+  SymbolDBBuilder(): strings(1, '\0'), symbols(), offsets(), lastModule(0) {};
+
+  inline void add(
+    addr_t addr,
+    char type,
+    std::string_view name,
+    std::string_view module = std::string_view()
+  ) {
+    if (module.empty()) {
+      lastModule = 0;
+    } else if (!lastModule || module != strings.c_str() + lastModule) {
+      lastModule = store(module);
+    }
+    symbols.push_back(Symbol{addr, store(name), lastModule, type});
+  }
+
+  /**
+   * @brief Add the symbols of a System.map or /proc/kallsyms file.
+   * 
+   * The kernel symbols of a /proc/kallsyms are already shifted by the KASLR
+   * offset of its boot, while those of the database are stored unshifted (as
+   * in System.map), so load a /proc/kallsyms with `modulesOnly` set.
+   * Absolute symbols are skipped (their value is not an address).
+   * 
+   * @param path
+   * @param modulesOnly only add module symbols, i.e., skip the lines without
+   * a `[module]`.
+   * @return size_t the number of symbols added.
+   */
+  inline size_t loadSymbols(const char *path, bool modulesOnly = false) {
+    std::string content;
+    if (!readSymbolFile(path, content)) {
+      throw SymbolDBError(std::string("Failed to read ") + path);
+    }
+    size_t added = 0;
+    forEachSymbolLine(content, [this, modulesOnly, &added](
+      addr_t addr, char type, std::string_view name, std::string_view module
+    ) {
+      if (isAbsoluteSymbol(type) || (modulesOnly && module.empty())) return;
+      add(addr, type, name, module);
+      added++;
+    });
+    return added;
+  }
+
+  /**
+   * @brief Store the known offsets of `table` (except `KPGD`, which is only
+   * valid for one boot).
+   * 
+   * @param table
+   */
+  inline void setOffsets(const offset::OffsetTable &table) {
+    offsets.clear();
+    for (unsigned int i = 0; i < offset::N_OFFSET_KEYS; i++) {
+      addr_t value = 0;
+      if (
+        i == offset::KPGD ||
+        table.tryGet(offset::OffsetKey(i), value) == VMI_FAILURE
+      ) continue;
+      offsets.push_back(
+        db::OffsetEntry{store(offset::offsetNames[i]), 0, value});
+    }
+  }
+
+  inline size_t size() const {
+    return symbols.size();
+  }
+
+  /**
+   * @brief Write the database to `path`.
+   * 
+   * @param path
+   */
+  inline void write(const char *path) {
+    std::stable_sort(symbols.begin(), symbols.end(),
+      [](const Symbol &a, const Symbol &b) { return a.addr < b.addr; });
+    uint64_t hashSize = 1;
+    while (hashSize < 2 * symbols.size()) hashSize <<= 1;
+    std::vector<uint32_t> hash(hashSize, 0);
+    for (size_t i = 0; i < symbols.size(); i++) {
+      std::string_view name(strings.c_str() + symbols[i].name);
+      for (
+        uint64_t slot = db::hashName(name) & (hashSize - 1);;
+        slot = (slot + 1) & (hashSize - 1)
+      ) {
+        if (!hash[slot]) {
+          hash[slot] = i + 1;
+          break;
+        }
+        // Keep the lowest address of duplicated (local) names
+        if (name == strings.c_str() + symbols[hash[slot] - 1].name) break;
+      }
+    }
+
+    db::Header header = {};
+    std::memcpy(header.magic, db::magic, sizeof(db::magic));
+    header.version = db::version;
+    header.nSymbols = symbols.size();
+    header.hashSize = hashSize;
+    header.nOffsets = offsets.size();
+    header.stringsSize = strings.size();
+    header.addrsOffset = db::align8(sizeof(db::Header));
+    header.infosOffset = db::align8(
+      header.addrsOffset + header.nSymbols * sizeof(uint64_t));
+    header.hashOffset = db::align8(
+      header.infosOffset + header.nSymbols * sizeof(db::SymbolInfo));
+    header.offsetsOffset = db::align8(
+      header.hashOffset + hashSize * sizeof(uint32_t));
+    header.stringsOffset = db::align8(
+      header.offsetsOffset + header.nOffsets * sizeof(db::OffsetEntry));
+
+    std::vector<uint8_t> buff(header.stringsOffset + header.stringsSize, 0);
+    std::memcpy(buff.data(), &header, sizeof(header));
+    uint64_t *addrs =
+      reinterpret_cast<uint64_t *>(buff.data() + header.addrsOffset);
+    db::SymbolInfo *infos =
+      reinterpret_cast<db::SymbolInfo *>(buff.data() + header.infosOffset);
+    for (size_t i = 0; i < symbols.size(); i++) {
+      addrs[i] = symbols[i].addr;
+      infos[i] = db::SymbolInfo{
+        symbols[i].name, symbols[i].module, symbols[i].type, {0, 0, 0}
+      };
+    }
+    std::memcpy(
+      buff.data() + header.hashOffset, hash.data(),
+      hashSize * sizeof(uint32_t));
+    std::memcpy(
+      buff.data() + header.offsetsOffset, offsets.data(),
+      offsets.size() * sizeof(db::OffsetEntry));
+    std::memcpy(
+      buff.data() + header.stringsOffset, strings.data(), strings.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(buff.data()), buff.size());
+    if (!file) throw SymbolDBError(std::string("Failed to write ") + path);
+    DBG() << "SymbolDBBuilder.write(): " << F_DEC(symbols.size())
+          << " symbol(s), " << F_DEC(offsets.size()) << " offset(s), "
+          << F_DEC(buff.size()) << " byte(s) to " << path << std::endl;
+  }
+};
+
+/**
+ * @brief Read-only view of a symbol database file compiled by
+ * `SymbolDBBuilder`, so that tools start without parsing a System.map or a
+ * profile.
+ * 
+ * The file is mapped (shared) and used in place: looking up a name is one
+ * probe sequence of the hash table, and the sorted addresses can be searched
+ * directly. Processes using the same file share its pages through the page
+ * cache.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * symbol::useSymbolDB(vmi, "debian11.symdb");  // See symbol.hh
+ * addr_t initTask = symbol::translateKernelSymbol(vmi, "init_task");
+ * ```
+ * 
+ */
+class SymbolDB {
+private:
+  std::string path;
+  const uint8_t *base;
+  size_t size;
+  const db::Header *header;
+  const uint64_t *addrs;
+  const db::SymbolInfo *infos;
+  const uint32_t *hash;
+  const db::OffsetEntry *offsets;
+  const char *strings;
+
+  inline SymbolDBError ioError(const char *op) const {
+    return SymbolDBError(
+      std::string(op) + " " + path + ": " + std::strerror(errno));
+  }
+
+  /**
+   * @brief Get the string at `offset` of the string section, "" if out of it.
+   * 
+   */
+  inline const char *stringAt(uint32_t offset) const {
+    return offset < header->stringsSize ? strings + offset : "";
+  }
+
+  /**
+   * @brief If a section of `count` entries of `entrySize` bytes at `offset`
+   * is 8-byte aligned and in the file (without overflowing).
+   * 
+   */
+  inline bool isSection(
+    uint64_t offset, uint64_t count, uint64_t entrySize
+  ) const {
+    return !(offset & 7) && offset <= size &&
+      count <= (size - offset) / entrySize;
+  }
+
+  /**
+   * @brief Check the header and that all the sections are in the file. The
+   * entries themselves are checked when used, so that opening does not touch
+   * every page.
+   * 
+   */
+  inline bool isValid() const {
+    return !(
+      size < sizeof(db::Header) ||
+      std::memcmp(header->magic, db::magic, sizeof(db::magic)) ||
+      header->version != db::version ||
+      !header->hashSize || (header->hashSize & (header->hashSize - 1)) ||
+      header->nSymbols >= header->hashSize ||
+      !header->stringsSize ||
+      !isSection(header->addrsOffset, header->nSymbols, sizeof(uint64_t)) ||
+      !isSection(
+        header->infosOffset, header->nSymbols, sizeof(db::SymbolInfo)) ||
+      !isSection(header->hashOffset, header->hashSize, sizeof(uint32_t)) ||
+      !isSection(
+        header->offsetsOffset, header->nOffsets, sizeof(db::OffsetEntry)) ||
+      !isSection(header->stringsOffset, header->stringsSize, 1) ||
+      base[header->stringsOffset + header->stringsSize - 1] != '\0'
+    );
+  }
+public:
+  SymbolDB(const std::string &_path):
+    path(_path), base(nullptr), size(0), header(nullptr), addrs(nullptr),
+    infos(nullptr), hash(nullptr), offsets(nullptr), strings(nullptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw ioError("Failed to open");
+    struct stat st;
+    if (fstat(fd, &st)) {
+      SymbolDBError err = ioError("Failed to stat");
+      ::close(fd);
+      throw err;
+    }
+    size = st.st_size;
+    if (size < sizeof(db::Header)) {
+      ::close(fd);
+      throw SymbolDBError("Not a symbol database: " + path);
+    }
+    void *ptr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) throw ioError("Failed to map");
+    base = reinterpret_cast<const uint8_t *>(ptr);
+    header = reinterpret_cast<const db::Header *>(base);
+    if (!isValid()) {
+      munmap(const_cast<uint8_t *>(base), size);
+      throw SymbolDBError(
+        "Not a symbol database or unsupported version: " + path);
+    }
+    addrs = reinterpret_cast<const uint64_t *>(base + header->addrsOffset);
+    infos = reinterpret_cast<const db::SymbolInfo *>(
+      base + header->infosOffset);
+    hash = reinterpret_cast<const uint32_t *>(base + header->hashOffset);
+    offsets = reinterpret_cast<const db::OffsetEntry *>(
+      base + header->offsetsOffset);
+    strings = reinterpret_cast<const char *>(base + header->stringsOffset);
+    DBG() << "SymbolDB(): " << F_DEC(header->nSymbols) << " symbol(s), "
+          << F_DEC(header->nOffsets) << " offset(s) from " << path
+          << std::endl;
+  }
+
+  SymbolDB(const SymbolDB &) = delete;
+  SymbolDB &operator=(const SymbolDB &) = delete;
+
+  ~SymbolDB() {
+    munmap(const_cast<uint8_t *>(base), size);
+  }
+
+  inline const std::string &getPath() const {
+    return path;
+  }
+
+  /**
+   * @brief Get the number of symbols.
+   * 
+   * @return size_t
+   */
+  inline size_t getSymbolCount() const {
+    return header->nSymbols;
+  }
+
+  /**
+   * @brief Find symbol `name` (the lowest address if duplicated).
+   * 
+   * @param[in] name
+   * @param[out] addr address as in the System.map or kallsyms (without the
+   * KASLR shift).
+   * @param[out] module empty for the kernel itself.
+   * @return status_t
+   */
+  inline status_t tryFind(
+    std::string_view name,
+    addr_t &addr,
+    std::string_view &module
+  ) const {
+    uint64_t mask = header->hashSize - 1;
+    uint64_t slot = db::hashName(name) & mask;
+    // Bounded, in case a malformed table has no empty slot
+    for (uint64_t i = 0; i < header->hashSize; i++, slot = (slot + 1) & mask) {
+      uint32_t entry = hash[slot];
+      if (!entry || entry > header->nSymbols) return VMI_FAILURE;
+      const db::SymbolInfo &info = infos[entry - 1];
+      if (name == stringAt(info.name)) {
+        addr = addrs[entry - 1];
+        module = stringAt(info.module);
+        return VMI_SUCCESS;
+      }
+    }
+    return VMI_FAILURE;
+  }
+
+  inline status_t tryFind(std::string_view name, addr_t &addr) const {
+    std::string_view module;
+    return tryFind(name, addr, module);
+  }
+
+  /**
+   * @brief Call `fn(addr, type, name, module)` for each symbol, in ascending
+   * address order. `module` is empty for the kernel itself.
+   * 
+   * @tparam Fn `void(addr_t, char, std::string_view, std::string_view)`.
+   * @param fn
+   */
+  template <typename Fn>
+  inline void forEachSymbol(Fn &&fn) const {
+    for (uint64_t i = 0; i < header->nSymbols; i++) {
+      fn(
+        addr_t(addrs[i]), infos[i].type,
+        std::string_view(stringAt(infos[i].name)),
+        std::string_view(stringAt(infos[i].module)));
+    }
+  }
+
+  /**
+   * @brief Get the offsets stored (unknown names are skipped).
+   * 
+   * @return offset::OffsetTable
+   */
+  inline offset::OffsetTable getOffsets() const {
+    offset::OffsetTable table;
+    for (uint64_t i = 0; i < header->nOffsets; i++) {
+      std::string_view name(stringAt(offsets[i].name));
+      for (unsigned int key = 0; key < offset::N_OFFSET_KEYS; key++) {
+        if (name == offset::offsetNames[key]) {
+          table.set(offset::OffsetKey(key), offsets[i].value);
+          break;
+        }
+      }
+    }
+    return table;
+  }
+};
+
+
+}
+}
+
+
+#endif /* F3B8D1E6_7A24_4C59_8E0F_2D6A9C4B7E31 */
@@ -0,0 +1,462 @@
+/**
+ * @file SymbolIndex.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Address to symbol+offset lookup of kernel (and module) symbols.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef C4E9A7B2_61D8_4F35_9B0E_3A7D2C8F5E16
+#define C4E9A7B2_61D8_4F35_9B0E_3A7D2C8F5E16
+
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/symbol/sysmap.hh>
+#include <guestutil/symbol/SymbolCache.hh>
+#include <guestutil/symbol/SymbolDB.hh>
+#include <debug.hh>
+
+#include <unordered_map>  // std::unordered_map
+#include <vector>  // std::vector
+#include <memory>  // std::unique_ptr
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <algorithm>  // std::sort, std::unique
+#include <ostream>  // std::ostream
+#include <cstdint>
+
+
+namespace guestutil {
+namespace symbol {
+
+
+/**
+ * @brief An address resolved to the nearest preceding symbol.
+ * 
+ */
+struct SymbolOffset {
+  std::string_view name;
+  /**
+   * @brief Empty for the kernel itself.
+   * 
+   */
+  std::string_view module;
+  addr_t addr;
+  addr_t offset;
+
+  /**
+   * @brief Print as `name+0x1a [module]`.
+   * 
+   */
+  inline friend
+  std::ostream &operator<<(std::ostream &os, const SymbolOffset &self) {
+    os << self.name;
+    if (self.offset) os << '+' << F_SHORT_UH64(self.offset) << std::dec;
+    if (!self.module.empty()) os << " [" << self.module << ']';
+    return os;
+  }
+};
+
+/**
+ * @brief Reverse index from kernel virtual addresses to the nearest preceding
+ * symbol, meant to be queried on every event (e.g., to print
+ * `interrupt_event.gla` or `mem_event.gla`).
+ * 
+ * Symbols are added with `add` or `load` (System.map or /proc/kallsyms
+ * format, the latter including module symbols), and become searchable after
+ * `build`. The addresses are kept in a flat array in Eytzinger (BFS) order,
+ * so a lookup is a branch-free descent whose first levels share cache lines,
+ * and does not allocate. Names are stored back to back in one buffer.
+ * 
+ * When several symbols share an address, a global one is preferred.
+ * 
+ * Example usage:
+ * 
+ * ```C++
+ * symbol::SymbolIndex &symbols = symbol::SymbolIndex::of(vmi);
+ * // In an event callback
+ * std::cout << symbols.describe(event->interrupt_event.gla) << std::endl;
+ * ```
+ * 
+ */
+class SymbolIndex {
+public:
+  /**
+   * @brief Default of the maximum distance from a symbol; addresses further
+   * than this from the nearest preceding symbol are not resolved.
+   * 
+   */
+  static constexpr addr_t defaultMaxOffset = 0x100000;
+private:
+  struct Entry {
+    addr_t addr;
+    /**
+     * @brief Offsets of the NUL-terminated name and module in `strings`.
+     * 
+     */
+    uint32_t name;
+    uint32_t module;
+    bool global;
+  };
+
+  /**
+   * @brief Names and modules, NUL-terminated. Offset 0 is the empty string.
+   * 
+   */
+  std::string strings;
+  /**
+   * @brief Module name offsets, so that each module is stored once.
+   * 
+   */
+  std::unordered_map<std::string, uint32_t> modules;
+  /**
+   * @brief Symbols, sorted by address after `build`.
+   * 
+   */
+  std::vector<Entry> entries;
+  /**
+   * @brief `tree[k]` is the address of `entries[ranks[k]]`, in Eytzinger
+   * order (1-based).
+   * 
+   */
+  std::vector<addr_t> tree;
+  std::vector<uint32_t> ranks;
+  bool built;
+
+  static std::unordered_map<vmi_instance_t, std::unique_ptr<SymbolIndex>> &
+  registry() {
+    /**
+     * @brief Global per `vmi_instance_t` symbol indices.
+     * 
+     */
+    static std::unordered_map<vmi_instance_t, std::unique_ptr<SymbolIndex>>
+      indices;
+    return indices;
+  }
+
+  inline uint32_t store(std::string_view str) {
+    uint32_t offset = strings.size();
+    strings.append(str);
+    strings.push_back('\0');
+    return offset;
+  }
+
+  inline uint32_t storeModule(std::string_view module) {
+    if (module.empty()) return 0;
+    auto it = modules.find(std::string(module));
+    if (it != modules.end()) return it->second;
+    uint32_t offset = store(module);
+    modules.emplace(std::string(module), offset);
+    return offset;
+  }
+
+  /**
+   * @brief Lay out `entries[i..]` in Eytzinger order starting at `tree[k]`.
+   * 
+   */
+  inline void layout(size_t &i, size_t k) {
+    if (k > entries.size()) return;
+    layout(i, 2 * k);
+    tree[k] = entries[i].addr;
+    ranks[k] = i++;
+    layout(i, 2 * k + 1);
+  }
+
+  /**
+   * @brief Absolute, undefined and weak undefined symbols are not indexed.
+   * 
+   */
+  static inline bool isIndexed(char type) {
+    return !isAbsoluteSymbol(type) && type != 'U' && type != 'w';
+  }
+
+  inline std::string_view stringAt(uint32_t offset) const {
+    return std::string_view(strings.c_str() + offset);
+  }
+
+  /**
+   * @brief Find the address of kernel symbol `name` by a linear scan (before
+   * `build`).
+   * 
+   */
+  inline bool tryFindKernelSymbol(std::string_view name, addr_t &addr) const {
+    for (const Entry &entry : entries) {
+      if (!entry.module && stringAt(entry.name) == name) {
+        addr = entry.addr;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Shift the kernel (non-module) symbols by `shift`.
+   * 
+   */
+  inline void shiftKernel(addr_t shift) {
+    for (Entry &entry : entries) {
+      if (!entry.module && isShiftedByKASLR(entry.addr)) entry.addr += shift;
+    }
+    built = false;
+  }
+
+  /**
+   * @brief Address of a symbol at System.map address `addr` of `module`,
+   * with a KASLR shift of `shift`.
+   * 
+   */
+  static inline addr_t shifted(
+    addr_t addr, std::string_view module, addr_t shift
+  ) {
+    // Module symbols in /proc/kallsyms are not affected by `shift`
+    return module.empty() && isShiftedByKASLR(addr) ? addr + shift : addr;
+  }
+public:
+  SymbolIndex(): strings(1, '\0'), modules(), entries(), tree(), ranks(),
+    built(false) {};
+
+  SymbolIndex(const SymbolIndex &) = delete;
+  SymbolIndex &operator=(const SymbolIndex &) = delete;
+
+  /**
+   * @brief Get the symbol index of the kernel of `vmi`, built on first use
+   * from the `SymbolDB` attached to its `SymbolCache` if any, or else from
+   * its System.map (shifted by the KASLR shift, see
+   * `SymbolCache::tryFindShift`, or left out if it is unknown). The
+   * System.map is parsed once, and the cache is not preloaded.
+   * 
+   * @param vmi
+   * @return SymbolIndex&
+   */
+  static SymbolIndex &of(vmi_instance_t vmi) {
+    auto &indices = registry();
+    auto it = indices.find(vmi);
+    if (it == indices.end()) {
+      std::unique_ptr<SymbolIndex> index(new SymbolIndex());
+      SymbolCache &cache = SymbolCache::of(vmi);
+      std::shared_ptr<const SymbolDB> db = cache.getDB();
+      const char *sysMap = vmi_get_linux_sysmap(vmi);
+      if (db) {
+        index->load(*db, cache.getShift());
+      } else if (cache.isComplete()) {
+        if (sysMap) index->load(sysMap, cache.getShift());
+      } else if (sysMap && index->load(sysMap)) {
+        // Parse once, unshifted, and probe the shift from what is loaded
+        SymbolIndex *loaded = index.get();
+        addr_t shift = 0;
+        if (cache.tryFindShift([loaded](const char *probe, addr_t &raw) {
+          return loaded->tryFindKernelSymbol(probe, raw);
+        }, shift) == VMI_SUCCESS) {
+          index->shiftKernel(shift);
+        } else {
+          // Better no symbols than wrong ones
+          DBG() << "SymbolIndex.of(): unknown KASLR shift, " << sysMap
+                << " not indexed" << std::endl;
+          index.reset(new SymbolIndex());
+        }
+      }
+      index->build();
+      it = indices.emplace(vmi, std::move(index)).first;
+    }
+    return *it->second;
+  }
+
+  /**
+   * @brief Free the symbol index of `vmi` (if any). Called before `vmi` is
+   * destroyed.
+   * 
+   * @param vmi
+   */
+  static void drop(vmi_instance_t vmi) {
+    registry().erase(vmi);
+  }
+
+  /**
+   * @brief Add a symbol. Call `build` before the next lookup.
+   * 
+   * @param addr
+   * @param name
+   * @param module empty for the kernel itself.
+   * @param global if preferred over other symbols at the same address.
+   */
+  inline void add(
+    addr_t addr,
+    std::string_view name,
+    std::string_view module = std::string_view(),
+    bool global = true
+  ) {
+    uint32_t moduleOffset = storeModule(module);
+    entries.push_back(Entry{addr, store(name), moduleOffset, global});
+    built = false;
+  }
+
+  /**
+   * @brief Add the symbols of a System.map or /proc/kallsyms file at `path`,
+   * shifted by `shift`. Call `build` before the next lookup.
+   * 
+   * Absolute, undefined and weak undefined symbols are skipped.
+   * 
+   * @param path
+   * @param shift KASLR shift (0 for /proc/kallsyms of the running guest).
+   * @return size_t the number of symbols added, 0 if the file cannot be read.
+   */
+  inline size_t load(const char *path, addr_t shift = 0) {
+    std::string content;
+    if (!readSymbolFile(path, content)) {
+      DBG() << "SymbolIndex.load(): failed to open " << path << std::endl;
+      return 0;
+    }
+    size_t loaded = 0;
+    forEachSymbolLine(content, [this, shift, &loaded](
+      addr_t addr, char type, std::string_view name, std::string_view module
+    ) {
+      if (!isIndexed(type)) return;
+      add(
+        shifted(addr, module, shift), name, module,
+        type >= 'A' && type <= 'Z'
+      );
+      loaded++;
+    });
+    DBG() << "SymbolIndex.load(): " << F_DEC(loaded) << " symbol(s) from "
+          << path << std::endl;
+    return loaded;
+  }
+
+  /**
+   * @brief Add the symbols of `db`, shifted by `shift`. Call `build` before
+   * the next lookup.
+   * 
+   * @param db
+   * @param shift KASLR shift.
+   * @return size_t the number of symbols added.
+   */
+  inline size_t load(const SymbolDB &db, addr_t shift = 0) {
+    size_t loaded = 0;
+    entries.reserve(entries.size() + db.getSymbolCount());
+    db.forEachSymbol([this, shift, &loaded](
+      addr_t addr, char type, std::string_view name, std::string_view module
+    ) {
+      if (!isIndexed(type)) return;
+      add(
+        shifted(addr, module, shift), name, module,
+        type >= 'A' && type <= 'Z'
+      );
+      loaded++;
+    });
+    return loaded;
+  }
+
+  /**
+   * @brief Sort the symbols and lay them out for lookups.
+   * 
+   */
+  inline void build() {
+    std::sort(entries.begin(), entries.end(),
+      [](const Entry &a, const Entry &b) {
+        if (a.addr != b.addr) return a.addr < b.addr;
+        return a.global && !b.global;
+      });
+    entries.erase(
+      std::unique(entries.begin(), entries.end(),
+        [](const Entry &a, const Entry &b) { return a.addr == b.addr; }),
+      entries.end());
+    entries.shrink_to_fit();
+    tree.assign(entries.size() + 1, 0);
+    ranks.assign(entries.size() + 1, 0);
+    size_t i = 0;
+    layout(i, 1);
+    built = true;
+  }
+
+  inline bool isBuilt() const {
+    return built;
+  }
+
+  /**
+   * @brief Get the number of distinct symbol addresses (after `build`).
+   * 
+   * @return size_t
+   */
+  inline size_t size() const {
+    return tree.empty() ? 0 : tree.size() - 1;
+  }
+
+  /**
+   * @brief Resolve `va` to the nearest symbol at or below it.
+   * 
+   * @param[in] va
+   * @param[out] result
+   * @param[in] maxOffset maximum `va - symbol address`.
+   * @return status_t `VMI_FAILURE` if there is no such symbol within
+   * `maxOffset`, or the index is not built.
+   */
+  inline status_t tryLookup(
+    addr_t va,
+    SymbolOffset &result,
+    addr_t maxOffset = defaultMaxOffset
+  ) const {
+    size_t n = size();
+    if (!built || !n) return VMI_FAILURE;
+    const addr_t *t = tree.data();
+    // Descend to the first address greater than `va`
+    size_t k = 1;
+    while (k <= n) {
+      __builtin_prefetch(t + 16 * k);
+      k = 2 * k + (t[k] <= va);
+    }
+    // Cancel the trailing right turns (and the last left turn)
+    k >>= __builtin_ffsll(~k);
+    size_t rank = k ? ranks[k] : n;
+    if (!rank) return VMI_FAILURE;  // Below the first symbol
+    const Entry &entry = entries[rank - 1];
+    if (va - entry.addr > maxOffset) return VMI_FAILURE;
+    result.name = stringAt(entry.name);
+    result.module = stringAt(entry.module);
+    result.addr = entry.addr;
+    result.offset = va - entry.addr;
+    return VMI_SUCCESS;
+  }
+
+  /**
+   * @brief Printable form of `va`: `symbol+0x1a [module]` if resolved, or
+   * the address in hex otherwise.
+   * 
+   */
+  class Description {
+  private:
+    addr_t va;
+    SymbolOffset symbol;
+    bool resolved;
+  public:
+    Description(const SymbolIndex &index, addr_t _va):
+      va(_va), symbol(), resolved(index.tryLookup(_va, symbol) == VMI_SUCCESS)
+      {};
+
+    inline friend
+    std::ostream &operator<<(std::ostream &os, const Description &self) {
+      if (self.resolved) os << self.symbol;
+      else os << F_UH64(self.va) << std::dec;
+      return os;
+    }
+  };
+
+  /**
+   * @brief Describe `va` for printing (see `Description`).
+   * 
+   * @param va
+   * @return Description
+   */
+  inline Description describe(addr_t va) const {
+    return Description(*this, va);
+  }
+};
+
+
+}
+}
+
+
+#endif /* C4E9A7B2_61D8_4F35_9B0E_3A7D2C8F5E16 */
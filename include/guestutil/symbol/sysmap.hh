@@ -0,0 +1,120 @@
+/**
+ * @file sysmap.hh
+ * @author Untitled (gnu.imm@outlook.com)
+ * @brief Parsing of System.map and /proc/kallsyms files.
+ * @version 0.1
+ * @date 2026-10-16
+ * 
+ * @copyright Copyright (c) 2026
+ * 
+ */
+#ifndef D8B2F5A1_3C47_4E69_A0D2_5F1B7E9C4A83
+#define D8B2F5A1_3C47_4E69_A0D2_5F1B7E9C4A83
+
+
+#include <libvmi/libvmi.h>
+
+#include <string>  // std::string
+#include <string_view>  // std::string_view
+#include <fstream>  // std::ifstream
+#include <sstream>  // std::stringstream
+#include <cstdlib>  // std::strtoull
+#include <cstring>  // std::memchr
+
+
+namespace guestutil {
+namespace symbol {
+
+
+/**
+ * @brief Read the whole file at `path` into `content`.
+ * 
+ * @param[in] path
+ * @param[out] content
+ * @return bool if the file is read.
+ */
+inline bool readSymbolFile(const char *path, std::string &content) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  content = buffer.str();
+  return true;
+}
+
+/**
+ * @brief If symbols of type `type` are absolute (their value is not an
+ * address, e.g., 0).
+ * 
+ * @param type
+ * @return bool
+ */
+inline bool isAbsoluteSymbol(char type) {
+  return type == 'a' || type == 'A';
+}
+
+/**
+ * @brief If the System.map address `addr` of a kernel (non-module) symbol is
+ * moved by KASLR, i.e., it is in the kernel half (per-CPU symbols are offsets
+ * in the per-CPU area, not addresses).
+ * 
+ * @param addr
+ * @return bool
+ */
+inline bool isShiftedByKASLR(addr_t addr) {
+  return addr >= 0xffff800000000000ull;
+}
+
+/**
+ * @brief Call `fn(addr, type, name, module)` for each
+ * `<hex address> <type> <name>[\t[<module>]]` line of `content`, i.e., a
+ * System.map or a /proc/kallsyms. `module` is empty for the kernel itself.
+ * Malformed lines are skipped.
+ * 
+ * @tparam Fn `void(addr_t, char, std::string_view, std::string_view)`.
+ * @param content
+ * @param fn
+ * @return size_t the number of symbols.
+ */
+template <typename Fn>
+inline size_t forEachSymbolLine(const std::string &content, Fn &&fn) {
+  size_t count = 0;
+  const char *p = content.data();
+  const char *end = p + content.size();
+  while (p < end) {
+    const char *eol = static_cast<const char *>(
+      std::memchr(p, '\n', end - p));
+    if (!eol) eol = end;
+    char *next = nullptr;
+    addr_t addr = std::strtoull(p, &next, 16);
+    if (next != p && next + 3 < eol && next[0] == ' ' && next[2] == ' ') {
+      char type = next[1];
+      std::string_view name(next + 3, eol - next - 3);
+      if (!name.empty() && name.back() == '\r') name.remove_suffix(1);
+      std::string_view module;
+      size_t sep = name.find_first_of("\t ");
+      if (sep != std::string_view::npos) {
+        module = name.substr(sep + 1);
+        name = name.substr(0, sep);
+        if (
+          module.size() >= 2 && module.front() == '[' && module.back() == ']'
+        ) {
+          module = module.substr(1, module.size() - 2);
+        }
+      }
+      if (!name.empty()) {
+        fn(addr, type, name, module);
+        count++;
+      }
+    }
+    p = eol + 1;
+  }
+  return count;
+}
+
+
+}
+}
+
+
+#endif /* D8B2F5A1_3C47_4E69_A0D2_5F1B7E9C4A83 */
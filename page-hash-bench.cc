@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/mem/PageHash.hh>
+
+#include <debug.hh>
+
+
+using namespace guestutil;
+
+
+/**
+ * Measure the single-core throughput of `memory::hashPage`, the page hash of
+ * `memory::PageHashSnapshot`, over a local buffer (no VM needed).
+ *
+ * Usage: page-hash-bench [<buffer MiB> [<rounds>]]
+ *
+ * The default buffer (64 MiB) is larger than the last level cache, so the
+ * figure includes reading the pages from memory, as in a snapshot.
+ */
+int main(int argc, char **argv) {
+  size_t mib = argc > 1 ? std::stoul(argv[1]) : 64;
+  unsigned int rounds = argc > 2 ? std::stoul(argv[2]) : 10;
+  constexpr size_t pageSize = memory::PageCache::pageSize;
+  size_t size = (mib << 20) / pageSize * pageSize;
+  if (!size || !rounds) {
+    std::cerr << "Usage: " << argv[0] << " [<buffer MiB> [<rounds>]]"
+      << std::endl;
+    return 1;
+  }
+  std::unique_ptr<uint8_t[]> buff(new uint8_t[size]);
+  for (size_t i = 0; i < size; i++) buff[i] = uint8_t(i * 31 + (i >> 12));
+
+  uint64_t sum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int round = 0; round < rounds; round++) {
+    for (size_t offset = 0; offset < size; offset += pageSize) {
+      sum += memory::hashPage(buff.get() + offset);
+    }
+  }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+
+  double bytes = double(size) * rounds;
+  std::cout << "Hashed " << F_DEC(size / pageSize) << " page(s) x "
+    << F_DEC(rounds) << " round(s) in " << elapsed.count() << " s" << std::endl
+    << "Throughput: " << bytes / elapsed.count() / 1e9 << " GB/s ("
+    << elapsed.count() * 1e9 / (bytes / pageSize) << " ns/page)" << std::endl
+    << "Checksum: " << F_SHORT_HEX(sum) << std::endl;
+  return 0;
+}
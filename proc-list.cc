@@ -6,14 +6,16 @@
 #include <libvmi/libvmi.h>
 #include <guestutil/VM.hh>
 #include <guestutil/ProcessList.hh>
+#include <guestutil/ProcessSnapshot.hh>
 #include <guestutil/mem.hh>
 #include <guestutil/mem/TempMem.hh>
+#include <guestutil/mem/Prefetcher.hh>
 #include <guestutil/breakpoint/Breakpoint.hh>
 
 
 using namespace guestutil;
 
-int doTheJob() {
+int doTheJob(const char *symbolDB) {
   vm::VM vm("debian11");
   std::cout << "VMI initialized." << std::endl;
 
@@ -22,6 +24,11 @@ int doTheJob() {
 
   vmi_instance_t &vmi = vm.getVMI();
 
+  if (symbolDB) {
+    // Precompiled with `symdb`
+    symbol::useSymbolDB(vmi, symbolDB);
+  }
+
   process::ProcessList procList;
   procList = process::ProcessList::fromVMI(vmi);
 
@@ -32,12 +39,26 @@ int doTheJob() {
 
   std::cout << "Target VM ID: " << vm.id() << std::endl;
 
+  // Fetch the next task while printing the current one
+  memory::Prefetcher prefetcher(vmi);
+
   list::ListItem swapperProc = procList.getFirst();
-  std::cout << '[' << std::right << std::setw(5) << procList.pid(vmi, swapperProc) << "] " << procList.name(vmi, swapperProc) << " (->tasks addr: " << reinterpret_cast<void *>(swapperProc.getVA()) << ')' << std::endl;
-  procList.forEach(vmi, [&vmi, &procList](list::ListItem procEntry) {
-    std::cout << '[' << std::right << std::setw(5) << procList.pid(vmi, procEntry) << "] " << procList.name(vmi, procEntry) << " (->tasks addr: " << reinterpret_cast<void *>(procEntry.getVA()) << ')' << std::endl;
+  process::task::TaskStruct::Snapshot swapperTask(procList.getTaskStruct());
+  swapperTask.read(vmi, procList.getObjectAddr(swapperProc));
+  std::cout << '[' << std::right << std::setw(5) << procList.pid(swapperTask) << "] " << procList.name(swapperTask) << " (->tasks addr: " << reinterpret_cast<void *>(swapperProc.getVA()) << ')' << std::endl;
+  procList.forEachSnapshot(vmi, [&procList](list::ListItem procEntry, const process::task::TaskStruct::Snapshot &task) {
+    std::cout << '[' << std::right << std::setw(5) << procList.pid(task) << "] " << procList.name(task) << " (->tasks addr: " << reinterpret_cast<void *>(procEntry.getVA()) << ')' << std::endl;
     return false;
   });
+  auto stats = prefetcher.getStats();
+  std::cout << "Prefetched pages: " << stats.served << '/' << stats.queued << std::endl;
+
+  // Column-wise snapshot for O(1) lookups by PID (valid while paused)
+  process::ProcessSnapshot procs(vmi, procList);
+  std::string_view initComm;
+  if (procs.tryGetComm(1, initComm) == VMI_SUCCESS) {
+    std::cout << "PID 1 of " << procs.size() << " task(s): " << initComm << std::endl;
+  }
 
   vm.resume();
 
@@ -45,8 +66,8 @@ int doTheJob() {
   return 0;
 }
 
-int main() {
+int main(int argc, char **argv) {
   try {
-    doTheJob();
+    doTheJob(argc > 1 ? argv[1] : nullptr);
   } catch (const std::exception &) { throw; }  // Use try-catch to ensure stack variables are properly destructed
 }
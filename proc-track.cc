@@ -0,0 +1,72 @@
+#include <iostream>
+#include <exception>
+#include <libvmi/libvmi.h>
+
+#include <guestutil/VM.hh>
+#include <guestutil/ProcessList.hh>
+#include <guestutil/ProcessTracker.hh>
+#include <guestutil/breakpoint/BreakpointRegistry.hh>
+#include <guestutil/event/Loop.hh>
+
+
+using namespace guestutil;
+
+int doTheJob() {
+  vm::VM vm("debian11", VMI_INIT_EVENTS);
+  std::cout << "VMI initialized." << std::endl;
+
+  // Resume in case it is already paused
+  vm.tryResume();
+
+  vmi_instance_t &vmi = vm.getVMI();
+
+  process::ProcessList procList;
+  procList = process::ProcessList::fromVMI(vmi);
+
+  event::Loop loop(vm);
+  breakpoint::BreakpointRegistry reg(vmi);
+  reg.registerEvent();
+
+  // The only full walk of the process list
+  vm.pause();
+  process::ProcessTracker tracker(vmi, procList, reg);
+  tracker.start();
+  std::cout << "Tracking " << tracker.size() << " process(es)" << std::endl;
+
+  int changes = 0;
+  std::function<void()> stopLoop = [&tracker, &reg, &loop]() {
+    tracker.stop();
+    reg.unregisterEvent();
+    loop.stop("onPause");
+  };
+  tracker.setListener([&changes, &loop, &stopLoop](process::TaskChange change, const process::TrackedTask &task) {
+    const char *what = change == process::TaskChange::CREATED ? "created" : change == process::TaskChange::EXITED ? "exited" : "renamed";
+    std::cout << '[' << std::right << std::setw(5) << task.pid << "] " << task.getComm() << ' ' << what << std::endl;
+    if (++changes == 20) {
+      loop.schedulePause(stopLoop, "ProcessTracker listener");
+    }
+  });
+  vm.resume();
+  event::EventError *err = loop.bump();
+  if (err) {
+    std::cout << "Event loop exited with error: " << err->what() << std::endl;
+  }
+
+  auto stats = tracker.getStats();
+  std::cout << "Created: " << stats.created << ", exited: " << stats.exited << ", renamed: " << stats.renamed << ", missed: " << stats.missed << std::endl;
+  std::cout << "Tracked process(es): " << tracker.size() << std::endl;
+
+  vm.resume();
+
+  // `vm::VM` destructor will do the clean-up
+  return 0;
+}
+
+int main() {
+  try {
+    return doTheJob();
+  } catch (std::exception &e) {
+    std::cout << "An error has occurred" << std::endl;
+    throw;
+  }
+}
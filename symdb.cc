@@ -0,0 +1,51 @@
+#include <iostream>
+#include <exception>
+#include <memory>
+
+#include <libvmi/libvmi.h>
+
+#include <guestutil/VM.hh>
+#include <guestutil/offset/OffsetTable.hh>
+#include <guestutil/symbol/SymbolDB.hh>
+
+
+using namespace guestutil;
+
+
+/**
+ * Compile a symbol database (see `symbol::SymbolDB`) for fast startup of the
+ * other tools.
+ *
+ * Usage: symdb <output> <System.map> [<offset profile> | -] [<kallsyms>]
+ *
+ * Without an offset profile (see `offset::OffsetTable::fromFile`), or with
+ * `-`, the offsets are resolved from LibVMI by attaching to the VM. Module
+ * symbols can be added from a /proc/kallsyms of the guest.
+ */
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+      << " <output> <System.map> [<offset profile> | -] [<kallsyms>]"
+      << std::endl;
+    return 1;
+  }
+  const char *output = argv[1];
+  symbol::SymbolDBBuilder builder;
+  std::cout << "Symbols: " << builder.loadSymbols(argv[2]) << " from "
+    << argv[2] << std::endl;
+  if (argc > 4) {
+    // Module symbols only, the kernel ones are KASLR-shifted
+    std::cout << "Module symbols: " << builder.loadSymbols(argv[4], true)
+      << " from " << argv[4] << std::endl;
+  }
+  if (argc > 3 && std::string(argv[3]) != "-") {
+    builder.setOffsets(offset::OffsetTable::fromFile(argv[3]));
+  } else {
+    vm::VM vm("debian11");
+    std::cout << "VMI initialized." << std::endl;
+    builder.setOffsets(offset::OffsetTable::of(vm.getVMI()));
+  }
+  builder.write(output);
+  std::cout << "Written " << output << std::endl;
+  return 0;
+}